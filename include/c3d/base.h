@@ -3,6 +3,7 @@
 #include "maths.h"
 
 #define C3D_DEFAULT_CMDBUF_SIZE 0x40000
+#define C3D_DEFAULT_QUEUE_DEPTH 32
 
 enum
 {
@@ -11,10 +12,56 @@ enum
 };
 
 bool C3D_Init(size_t cmdBufSize);
+
+/**
+ * @brief Initializes citro3d with a given GX queue depth.
+ * @param[in] cmdBufSize Command buffer size, in bytes.
+ * @param[in] queueDepth Maximum number of GX commands (command lists, transfers, fills) queued at once.
+ * @note Frames needing more queue entries than this have to wait for the GPU to catch up.
+ */
+bool C3D_InitEx(size_t cmdBufSize, u16 queueDepth);
 void C3D_Fini(void);
 
 float C3D_GetCmdBufUsage(void);
 
+/**
+ * @brief Enables flushing only the linear memory written by the CPU at C3D_FrameEnd.
+ * @param[in] threshold Total size of the recorded ranges above which the whole linear
+ *                      heap is flushed instead. 0 restores the default full flush.
+ * @note Once enabled, vertex/index buffers and other data written by the application
+ *       must be reported with C3D_FlushRange. The command buffer and textures loaded
+ *       through citro3d (C3D_TexLoadImage, C3D_TexGenerateMipmap, Tex3DS) are tracked
+ *       automatically.
+ */
+void C3D_FlushTracking(size_t threshold);
+
+/// Records a range of linear memory written by the CPU, to be flushed before the GPU uses it.
+void C3D_FlushRange(const void* addr, size_t size);
+
+/**
+ * @brief Opaque snapshot of the logical render state.
+ *
+ * Covers the shader program, attribute and buffer info, effect (depth, stencil,
+ * blending...), TexEnv stages and buffer, fog color and LUT, bound textures,
+ * procedural texture, light environment, fixed attributes and uniforms. Render
+ * target, viewport and scissor are left to C3D_FrameDrawOn. Bound objects (program,
+ * textures, light environment, LUTs) are saved by pointer, not by contents.
+ */
+typedef struct C3D_ContextState C3D_ContextState;
+
+C3D_ContextState* C3D_ContextStateNew(void);
+void C3D_ContextStateDelete(C3D_ContextState* state);
+
+/// Captures the current render state.
+void C3D_ContextSave(C3D_ContextState* state);
+
+/**
+ * @brief Makes a saved render state current.
+ * @note Only the parts differing from the current state are marked dirty, so
+ *       restoring a state that is mostly current emits few commands.
+ */
+void C3D_ContextRestore(const C3D_ContextState* state);
+
 void C3D_BindProgram(shaderProgram_s* program);
 
 void C3D_SetViewport(u32 x, u32 y, u32 w, u32 h);
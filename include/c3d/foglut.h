@@ -0,0 +1,20 @@
+#pragma once
+#include "types.h"
+#include "lightlut.h"
+#include <math.h>
+
+typedef struct
+{
+	u32 data[128];
+} C3D_FogLut;
+
+static inline float FogLut_CalcZ(float depth, float near, float far)
+{
+	return far*near/(depth*(far-near)+near);
+}
+
+void FogLut_FromArray(C3D_FogLut* lut, const float data[256]);
+void FogLut_Exp(C3D_FogLut* lut, float density, float gradient, float near, float far);
+void FogLut_FromShapeRange(C3D_FogLut* lut, C3D_LutShape shape, float a, float b, float near, float far, int first, int count);
+
+#define FogLut_FromShape(lut, shape, a, b, near, far) FogLut_FromShapeRange((lut), (shape), (a), (b), (near), (far), 0, 128)
@@ -29,6 +29,17 @@ C3D_FrameBuf* C3D_GetFrameBuf(void);
 void C3D_SetFrameBuf(C3D_FrameBuf* fb);
 void C3D_FrameBufTex(C3D_FrameBuf* fb, C3D_Tex* tex, GPU_TEXFACE face, int level);
 void C3D_FrameBufClear(C3D_FrameBuf* fb, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+
+/**
+ * @brief Clears a rectangle of a framebuffer with memory fills.
+ * @param[in] x,y,w,h Rectangle in window coordinates (as for the viewport and scissor),
+ *                    clipped to the framebuffer.
+ * @return false if the rectangle is not aligned to the 8x8 tiles (32x32 in block32
+ *         mode) of the framebuffer, in which case nothing is cleared. The framebuffer
+ *         is stored bottom-up, so tile rows are counted from the bottom of the window.
+ * @note One fill span is issued per tile row, or a single one for full-width rectangles.
+ */
+bool C3D_FrameBufClearRect(C3D_FrameBuf* fb, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 x, u16 y, u16 w, u16 h);
 void C3D_FrameBufTransfer(C3D_FrameBuf* fb, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags);
 
 static inline void C3D_FrameBufAttrib(C3D_FrameBuf* fb, u16 width, u16 height, bool block32)
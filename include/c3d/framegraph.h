@@ -0,0 +1,79 @@
+#pragma once
+#include "renderqueue.h"
+
+#define C3D_FRAMEGRAPH_MAX_PASSES 16
+#define C3D_FRAMEGRAPH_MAX_INPUTS 4
+
+// Flags for C3D_FrameGraphAddPass
+enum
+{
+	C3D_PASS_KEEP = BIT(0), // Never culled, even if nothing in the graph consumes its output
+};
+
+typedef void (* C3D_PassFunc)(void* param);
+
+typedef struct
+{
+	const char* name;
+	C3D_RenderTarget* output;
+	C3D_RenderTarget* inputs[C3D_FRAMEGRAPH_MAX_INPUTS];
+	u8 numInputs;
+	u8 flags;
+	C3D_ClearBits clearBits;
+	u32 clearColor, clearDepth;
+	C3D_PassFunc func;
+	void* param;
+} C3D_Pass;
+
+typedef struct
+{
+	C3D_Pass passes[C3D_FRAMEGRAPH_MAX_PASSES];
+	int numPasses;
+
+	// Filled in by C3D_FrameGraphCompile
+	u8 order[C3D_FRAMEGRAPH_MAX_PASSES];
+	int numOrdered;
+	u16 hoistClear; // Passes whose clear runs up front, merged with the other clears
+	u16 barrier;    // Passes sampling a target rendered earlier in the frame
+	bool compiled;
+} C3D_FrameGraph;
+
+void C3D_FrameGraphInit(C3D_FrameGraph* fg);
+
+/**
+ * @brief Declares a pass drawing onto a render target.
+ * @param[in] fg     Frame graph.
+ * @param[in] name   Pass name, kept as a pointer.
+ * @param[in] output Render target drawn on.
+ * @param[in] func   Callback recording the draws of the pass.
+ * @param[in] param  Callback parameter.
+ * @param[in] flags  C3D_PASS_* flags.
+ * @return Pass id, or -1 if the graph is full.
+ * @note Passes writing to a target linked to a screen output are always kept; other
+ *       passes are only kept when a kept pass reads their output, directly or not.
+ */
+int C3D_FrameGraphAddPass(C3D_FrameGraph* fg, const char* name, C3D_RenderTarget* output, C3D_PassFunc func, void* param, u8 flags);
+
+/// Declares that a pass samples the given render target (e.g. a shadow or reflection map).
+bool C3D_FrameGraphPassRead(C3D_FrameGraph* fg, int pass, C3D_RenderTarget* input);
+
+/// Makes a pass clear its output before drawing.
+void C3D_FrameGraphPassClear(C3D_FrameGraph* fg, int pass, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+
+/**
+ * @brief Orders the passes by their dependencies and culls unused ones.
+ * @return false if the dependencies form a cycle.
+ * @note Readers of a target run after all of its writers, and writers of the same
+ *       target run in declaration order. Otherwise declaration order is kept.
+ */
+bool C3D_FrameGraphCompile(C3D_FrameGraph* fg);
+
+/**
+ * @brief Runs the graph within the current frame, compiling it first if needed.
+ *
+ * Clears of targets not written earlier in the frame are issued together up front,
+ * so they are merged into two-buffer memory fills. Framebuffer flush/invalidate and
+ * a texture cache clear are only inserted before passes sampling a target rendered
+ * earlier in the frame.
+ */
+bool C3D_FrameGraphExecute(C3D_FrameGraph* fg);
@@ -0,0 +1,50 @@
+#pragma once
+#include "types.h"
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct
+{
+	float cpuTime;    // C3D_FrameBegin to C3D_FrameEnd, in milliseconds
+	float gpuTime;    // C3D_FrameEnd to queue completion, in milliseconds
+	u32 cmdWords;     // Command buffer words used by the frame
+	u32 vblankMisses; // VBlanks the frame was presented late by
+} C3D_FrameStats;
+
+typedef enum
+{
+	C3D_STAT_CPU,
+	C3D_STAT_GPU,
+	C3D_STAT_CMDWORDS,
+	C3D_STAT_VBLANKMISSES,
+} C3D_FrameStat;
+
+typedef enum
+{
+	C3D_STATS_CSV,
+	C3D_STATS_JSON,
+} C3D_FrameStatsFormat;
+
+/**
+ * @brief Starts recording per-frame statistics.
+ * @param[in] capacity Number of frames kept in the history ring, 0 to stop recording.
+ * @return false on allocation failure.
+ * @note A frame is recorded at the following C3D_FrameBegin, once its GPU time is known.
+ */
+bool C3D_FrameStatsInit(size_t capacity);
+void C3D_FrameStatsReset(void);
+
+size_t C3D_FrameStatsCount(void);
+
+/// Returns the i-th recorded frame, 0 being the oldest still in the history.
+const C3D_FrameStats* C3D_FrameStatsGet(size_t i);
+
+/**
+ * @brief Computes a percentile over the recorded history (nearest rank).
+ * @param[in] stat       Statistic to query.
+ * @param[in] percentile Percentile in [0,100], e.g. 50, 95 or 99.
+ */
+float C3D_FrameStatsPercentile(C3D_FrameStat stat, float percentile);
+
+/// Writes the recorded history, followed by p50/p95/p99 in JSON mode.
+bool C3D_FrameStatsExport(FILE* f, C3D_FrameStatsFormat format);
@@ -52,7 +52,7 @@ enum
 struct C3D_LightEnv_t
 {
 	u32 flags;
-	C3D_LightLut* luts[6];
+	const C3D_LightLut* luts[6];
 	float ambient[3];
 	C3D_Light* lights[8];
 	C3D_LightEnvConf conf;
@@ -64,7 +64,7 @@ void C3D_LightEnvBind(C3D_LightEnv* env);
 
 void C3D_LightEnvMaterial(C3D_LightEnv* env, const C3D_Material* mtl);
 void C3D_LightEnvAmbient(C3D_LightEnv* env, float r, float g, float b);
-void C3D_LightEnvLut(C3D_LightEnv* env, GPU_LIGHTLUTID lutId, GPU_LIGHTLUTINPUT input, bool negative, C3D_LightLut* lut);
+void C3D_LightEnvLut(C3D_LightEnv* env, GPU_LIGHTLUTID lutId, GPU_LIGHTLUTINPUT input, bool negative, const C3D_LightLut* lut);
 
 enum
 {
@@ -125,7 +125,7 @@ struct C3D_Light_t
 {
 	u16 flags, id;
 	C3D_LightEnv* parent;
-	C3D_LightLut *lut_SP, *lut_DA;
+	const C3D_LightLut *lut_SP, *lut_DA;
 	float ambient[3];
 	float diffuse[3];
 	float specular0[3];
@@ -145,9 +145,9 @@ void C3D_LightPosition(C3D_Light* light, C3D_FVec* pos);
 void C3D_LightShadowEnable(C3D_Light* light, bool enable);
 void C3D_LightSpotEnable(C3D_Light* light, bool enable);
 void C3D_LightSpotDir(C3D_Light* light, float x, float y, float z);
-void C3D_LightSpotLut(C3D_Light* light, C3D_LightLut* lut);
+void C3D_LightSpotLut(C3D_Light* light, const C3D_LightLut* lut);
 void C3D_LightDistAttnEnable(C3D_Light* light, bool enable);
-void C3D_LightDistAttn(C3D_Light* light, C3D_LightLutDA* lut);
+void C3D_LightDistAttn(C3D_Light* light, const C3D_LightLutDA* lut);
 
 static inline void C3D_LightColor(C3D_Light* light, float r, float g, float b)
 {
@@ -26,10 +26,45 @@ static inline float spot_step(float angle, float cutoff)
 	return angle >= cutoff ? 1.0f : 0.0f;
 }
 
+// Function families understood by the *_FromShape builders
+typedef enum
+{
+	C3D_LUT_POW,        // x^a
+	C3D_LUT_EXP,        // exp(-(a*x)^b)
+	C3D_LUT_LINEAR,     // 0 at x=a, 1 at x=b, clamped
+	C3D_LUT_SMOOTHSTEP, // smoothstep from 0 at x=a to 1 at x=b
+	C3D_LUT_QUADRATIC,  // 1/(1 + a*x + b*x^2)
+} C3D_LutShape;
+
+static inline __attribute__((always_inline)) float C3D_LutShapeEval(C3D_LutShape shape, float x, float a, float b)
+{
+	float t;
+	switch (shape)
+	{
+		case C3D_LUT_POW:
+			return powf(x, a);
+		case C3D_LUT_EXP:
+			return expf(-powf(a*x, b));
+		case C3D_LUT_LINEAR:
+		case C3D_LUT_SMOOTHSTEP:
+			t = (x-a)/(b-a);
+			t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+			return shape == C3D_LUT_LINEAR ? t : t*t*(3.0f-2.0f*t);
+		case C3D_LUT_QUADRATIC:
+			return 1.0f / (1.0f + a*x + b*x*x);
+	}
+	return 0.0f;
+}
+
 void LightLut_FromArray(C3D_LightLut* lut, float* data);
+void LightLut_FromShapeRange(C3D_LightLut* lut, C3D_LutShape shape, float a, float b, bool negative, int first, int count);
+void LightLutDA_FromShapeRange(C3D_LightLutDA* lut, C3D_LutShape shape, float from, float to, float a, float b, int first, int count);
 void LightLut_FromFunc(C3D_LightLut* lut, C3D_LightLutFunc func, float param, bool negative);
 void LightLutDA_Create(C3D_LightLutDA* lut, C3D_LightLutFuncDA func, float from, float to, float arg0, float arg1);
 
 #define LightLut_Phong(lut, shininess) LightLut_FromFunc((lut), powf, (shininess), false)
 #define LightLut_Spotlight(lut, angle) LightLut_FromFunc((lut), spot_step, cosf(angle), true)
 #define LightLutDA_Quadratic(lut, from, to, linear, quad) LightLutDA_Create((lut), quadratic_dist_attn, (from), (to), (linear), (quad))
+
+#define LightLut_FromShape(lut, shape, a, b, negative) LightLut_FromShapeRange((lut), (shape), (a), (b), (negative), 0, 256)
+#define LightLutDA_FromShape(lut, shape, from, to, a, b) LightLutDA_FromShapeRange((lut), (shape), (from), (to), (a), (b), 0, 256)
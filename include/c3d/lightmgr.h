@@ -0,0 +1,85 @@
+#pragma once
+#include "light.h"
+
+//-----------------------------------------------------------------------------
+// Light manager
+//-----------------------------------------------------------------------------
+
+#define C3D_LIGHTMGR_BUCKETS 256
+
+enum
+{
+	C3DF_ManagedLight_Used = BIT(0),
+};
+
+typedef struct
+{
+	C3D_FVec position; // World space
+	float radius;
+	float color[3];
+	const C3D_LightLutDA* lut_DA;
+	s32 next;          // Bucket chain, or free list when unused
+	u16 bucket;
+	u16 flags;
+	u32 version;
+} C3D_ManagedLight;
+
+typedef struct
+{
+	C3D_LightEnv* env;
+	C3D_Light hw[8];
+	int numSlots;
+	s32 slotLight[8];
+	u32 slotVersion[8];
+	u32 slotView[8];
+
+	C3D_ManagedLight* lights;
+	int numLights, capacity;
+	s32 freeList;
+	float cellSize, maxRadius;
+	s32 buckets[C3D_LIGHTMGR_BUCKETS];
+	u32 bucketStamp[C3D_LIGHTMGR_BUCKETS];
+	u32 stamp;
+
+	C3D_Mtx view;
+	u32 viewVersion;
+} C3D_LightMgr;
+
+/**
+ * @brief Initializes a light manager driving the free light slots of a light environment.
+ * @param[out] mgr      Light manager.
+ * @param[in]  env      Light environment whose unused C3D_Light slots are taken over.
+ * @param[in]  cellSize Edge length of a spatial grid cell, ideally close to a typical light radius.
+ * @return true if at least one hardware slot was available.
+ */
+bool C3D_LightMgrInit(C3D_LightMgr* mgr, C3D_LightEnv* env, float cellSize);
+void C3D_LightMgrFini(C3D_LightMgr* mgr);
+
+/**
+ * @brief Sets the view matrix used to bring light positions into eye space.
+ * @note Only slots whose light is selected again get their position rewritten.
+ */
+void C3D_LightMgrViewMatrix(C3D_LightMgr* mgr, const C3D_Mtx* view);
+
+/**
+ * @brief Adds a point light.
+ * @return Light handle, or -1 on allocation failure.
+ */
+int  C3D_LightMgrAdd(C3D_LightMgr* mgr, C3D_FVec position, float radius);
+void C3D_LightMgrRemove(C3D_LightMgr* mgr, int handle);
+void C3D_LightMgrMove(C3D_LightMgr* mgr, int handle, C3D_FVec position);
+void C3D_LightMgrColor(C3D_LightMgr* mgr, int handle, float r, float g, float b);
+void C3D_LightMgrDistAttn(C3D_LightMgr* mgr, int handle, const C3D_LightLutDA* lut);
+
+/**
+ * @brief Binds the most influential lights for an object to the hardware slots.
+ * @param[in] mgr    Light manager.
+ * @param[in] center Bounding sphere center, world space.
+ * @param[in] radius Bounding sphere radius.
+ * @return Number of lights bound.
+ *
+ * Lights staying selected keep their slot, so only newly assigned or modified
+ * lights are rewritten, and the light permutation only changes with the
+ * set of active slots.
+ */
+int  C3D_LightMgrSelect(C3D_LightMgr* mgr, C3D_FVec center, float radius);
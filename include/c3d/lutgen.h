@@ -0,0 +1,209 @@
+#pragma once
+#ifndef __cplusplus
+#error "c3d/lutgen.h requires a C++11 compiler"
+#endif
+extern "C" {
+#include "lightlut.h"
+#include "foglut.h"
+}
+
+/*
+ * Compile-time counterparts of the LightLut/FogLut/ProcTexLut builders.
+ *
+ * Tables are sampled and quantized like the runtime functions, so a generator
+ * fed with a functor doing plain float arithmetic yields the same words. They
+ * can be placed in read-only data:
+ *
+ *   static constexpr C3D_LightLut phong = C3D::LutGen::LightLut(C3D::LutGen::Phong{30.0f});
+ *   static constexpr C3D_FogLut fog = C3D::LutGen::FogLut(C3D::LutGen::FogExp{0.05f, 1.0f, 0.1f, 100.0f});
+ *
+ * Functors are literal types with a constexpr float operator()(float). The
+ * stock functors below rely on the compiler folding powf/expf/cosf, which is
+ * correctly rounded, while the runtime calls newlib. They are not guaranteed to
+ * be bit-identical: an entry may be off by one quantization step where the two
+ * disagree in the last bit, which test/pc bounds to 1% of the entries. Build the
+ * table at runtime when that matters.
+ */
+
+namespace C3D
+{
+namespace LutGen
+{
+
+template <unsigned... Is> struct Indices { };
+template <unsigned N, unsigned... Is> struct MakeIndices : MakeIndices<N-1, N-1, Is...> { };
+template <unsigned... Is> struct MakeIndices<0, Is...> { typedef Indices<Is...> type; };
+
+namespace detail
+{
+
+// LightLut_FromArray
+constexpr u32 LightVal(float in)
+{
+	return in > 0.0f ? ((in*0x1000 < 0x1000) ? (u32)(in*0x1000) : 0xFFF) : 0;
+}
+
+constexpr u32 LightDiffMag(float diff)
+{
+	return (diff*0x800 < 0x800) ? (u32)(diff*0x800) : 0x7FF;
+}
+
+constexpr u32 LightDiff(float diff)
+{
+	return diff == 0.0f ? 0 : diff < 0 ? (0x800 | LightDiffMag(-diff)) : LightDiffMag(diff);
+}
+
+constexpr u32 LightEntry(float val, float next)
+{
+	return LightVal(val) | (LightDiff(next-val) << 12);
+}
+
+// Signed table position of entry i in two's complement mode
+constexpr int LightPos(unsigned i, bool negative)
+{
+	return negative ? (i < 128 ? (int)i : (int)i-256) : (int)i;
+}
+
+template <typename F>
+constexpr u32 LightSample(const F& f, int pos, int max)
+{
+	return LightEntry(f((float)pos/max), f((float)(pos+1)/max));
+}
+
+template <typename F, unsigned... Is>
+constexpr C3D_LightLut LightLut(const F& f, bool negative, Indices<Is...>)
+{
+	return C3D_LightLut{{ LightSample(f, LightPos(Is, negative), negative ? 128 : 256)... }};
+}
+
+template <typename F>
+constexpr float DASample(const F& f, float from, float range, unsigned i)
+{
+	return f(from + range*i/256.0f);
+}
+
+template <typename F, unsigned... Is>
+constexpr C3D_LightLut LightLutDA(const F& f, float from, float range, Indices<Is...>)
+{
+	return C3D_LightLut{{ LightEntry(DASample(f, from, range, Is), DASample(f, from, range, Is+1))... }};
+}
+
+// FogLut_FromArray
+constexpr u32 FogVal(float in)
+{
+	return in > 0.0f ? ((in*0x800 < 0x800) ? (u32)(in*0x800) : 0x7FF) : 0;
+}
+
+constexpr float FogClamp(float diff)
+{
+	return diff < -0x1000 ? -0x1000 : diff > 0xFFF ? 0xFFF : diff;
+}
+
+constexpr u32 FogDiff(float diff)
+{
+	return diff != 0.0f ? ((s32)FogClamp(diff*0x800) & 0x1FFF) : 0;
+}
+
+constexpr u32 FogEntry(float val, float next)
+{
+	return FogDiff(next-val) | (FogVal(val) << 13);
+}
+
+template <typename F, unsigned... Is>
+constexpr C3D_FogLut FogLut(const F& f, Indices<Is...>)
+{
+	return C3D_FogLut{{ FogEntry(f(Is/128.0f), f((Is+1)/128.0f))... }};
+}
+
+// ProcTexLut_FromArray
+constexpr u32 ProcTexVal(float val)
+{
+	return 0xFFF*(val < 0.0f ? 0.0f : val > 1.0f ? 1.0f : val);
+}
+
+constexpr u32 ProcTexEntry(u32 cur, u32 next)
+{
+	return cur | (((next-cur)&0xFFF) << 12);
+}
+
+} // namespace detail
+
+/// Equivalent of LightLut_FromFunc, sampling f over [0,1] or [-1,1] when negative.
+template <typename F>
+constexpr C3D_LightLut LightLut(const F& f, bool negative = false)
+{
+	return detail::LightLut(f, negative, typename MakeIndices<256>::type());
+}
+
+/// Equivalent of LightLutDA_Create, sampling f over [from,to].
+template <typename F>
+constexpr C3D_LightLutDA LightLutDA(const F& f, float from, float to)
+{
+	return C3D_LightLutDA{ detail::LightLutDA(f, from, to-from, typename MakeIndices<256>::type()),
+		-from*(1.0f/(to-from)), 1.0f/(to-from) };
+}
+
+/// Equivalent of FogLut_FromArray fed with f sampled over normalized depth [0,1].
+template <typename F>
+constexpr C3D_FogLut FogLut(const F& f)
+{
+	return detail::FogLut(f, typename MakeIndices<128>::type());
+}
+
+/// C3D_ProcTexLut is an array type, so it is returned wrapped; bind &lut.data.
+struct ProcTexLut
+{
+	u32 data[128];
+};
+
+template <typename F, unsigned... Is>
+constexpr ProcTexLut ProcTexLutImpl(const F& f, Indices<Is...>)
+{
+	return ProcTexLut{{ detail::ProcTexEntry(detail::ProcTexVal(f(Is/128.0f)), detail::ProcTexVal(f((Is+1)/128.0f)))... }};
+}
+
+/// Equivalent of ProcTexLut_FromArray fed with f sampled at i/128 for i in [0,128].
+template <typename F>
+constexpr ProcTexLut ProcTexLutFromFunc(const F& f)
+{
+	return ProcTexLutImpl(f, typename MakeIndices<128>::type());
+}
+
+/// LightLut_Phong
+struct Phong
+{
+	float shininess;
+	constexpr float operator()(float x) const { return __builtin_powf(x, shininess); }
+};
+
+/// spot_step, see LightLut_Spotlight
+struct SpotStep
+{
+	float cutoff;
+	constexpr float operator()(float x) const { return x >= cutoff ? 1.0f : 0.0f; }
+};
+
+constexpr SpotStep Spotlight(float angle)
+{
+	return SpotStep{ __builtin_cosf(angle) };
+}
+
+/// quadratic_dist_attn, see LightLutDA_Quadratic
+struct QuadraticDistAttn
+{
+	float linear, quad;
+	constexpr float operator()(float dist) const { return 1.0f / (1.0f + linear*dist + quad*dist*dist); }
+};
+
+/// FogLut_Exp
+struct FogExp
+{
+	float density, gradient, near, far;
+	constexpr float operator()(float depth) const
+	{
+		return __builtin_expf(-__builtin_powf(density*(far*near/(depth*(far-near)+near)), gradient));
+	}
+};
+
+} // namespace LutGen
+} // namespace C3D
@@ -0,0 +1,61 @@
+#pragma once
+#include "types.h"
+
+#define C3D_PACKET_WRAP 0xFFFF // Internal: padding up to the end of the ring
+
+/// Bytes taken by a packet with the given payload size, header included.
+#define C3D_PACKET_SIZE(_size) (sizeof(C3D_PacketHeader) + (((_size)+3) &~ 3))
+
+typedef struct
+{
+	u16 op;
+	u16 size; // Payload size in bytes, not counting the header or alignment
+} C3D_PacketHeader;
+
+/**
+ * @brief Lock-free single producer, single consumer packet ring.
+ *
+ * Offsets are free running and wrapped by masking, so the capacity must be a
+ * power of two. Packets are 4-byte aligned and never straddle the end of the
+ * ring. Only the producer writes head, only the consumer writes tail.
+ */
+typedef struct
+{
+	u8* buf;
+	u32 size;
+	u32 head;    // Published write offset
+	u32 tail;    // Published read offset
+	u32 reserve; // Producer only: write offset after the packet being built
+} C3D_PacketQueue;
+
+/**
+ * @brief Initializes a packet queue over a caller provided buffer.
+ * @param[in] buf  Buffer, at least 4-byte aligned.
+ * @param[in] size Buffer size in bytes, a power of two.
+ * @return false if the size is not a power of two of at least 16 bytes.
+ */
+bool C3D_PacketQueueInit(C3D_PacketQueue* q, void* buf, u32 size);
+
+/**
+ * @brief Producer: starts a packet.
+ * @param[in] op   Opcode, anything but C3D_PACKET_WRAP.
+ * @param[in] size Payload size in bytes, at most a quarter of the queue size.
+ * @return Payload pointer, or NULL if the consumer has not freed enough space yet.
+ * @note The packet is only visible to the consumer after C3D_PacketCommit.
+ */
+void* C3D_PacketBegin(C3D_PacketQueue* q, u16 op, u32 size);
+void C3D_PacketCommit(C3D_PacketQueue* q);
+
+/**
+ * @brief Consumer: returns the oldest committed packet without removing it.
+ * @param[out] op   Opcode.
+ * @param[out] size Payload size in bytes.
+ * @return Payload pointer, or NULL if the queue is empty.
+ */
+const void* C3D_PacketPeek(C3D_PacketQueue* q, u16* op, u32* size);
+
+/// Consumer: removes the packet returned by the last C3D_PacketPeek.
+void C3D_PacketPop(C3D_PacketQueue* q);
+
+/// Returns true if the consumer has popped every committed packet.
+bool C3D_PacketQueueEmpty(C3D_PacketQueue* q);
@@ -88,7 +88,7 @@ void C3D_ProcTexBind(int texCoordId, C3D_ProcTex* pt);
 
 // GPU_LUT_NOISE, GPU_LUT_RGBMAP, GPU_LUT_ALPHAMAP
 typedef u32 C3D_ProcTexLut[128];
-void C3D_ProcTexLutBind(GPU_PROCTEX_LUTID id, C3D_ProcTexLut* lut);
+void C3D_ProcTexLutBind(GPU_PROCTEX_LUTID id, const C3D_ProcTexLut* lut);
 void ProcTexLut_FromArray(C3D_ProcTexLut* lut, const float in[129]);
 
 void C3D_ProcTexColorLutBind(C3D_ProcTexColorLut* lut);
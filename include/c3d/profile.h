@@ -0,0 +1,42 @@
+#pragma once
+#include "types.h"
+
+#define C3D_PROFILE_MAX_SCOPES 16
+#define C3D_PROFILE_HISTORY    16
+
+typedef struct
+{
+	const char* name;
+	float gpuTime;    // Last frame, in milliseconds
+	float gpuAverage; // Rolling average over the last C3D_PROFILE_HISTORY frames
+	float gpuMax;     // Maximum over the same window
+	u32 splits;       // Command lists submitted inside the scope last frame
+	float history[C3D_PROFILE_HISTORY];
+	u32 frames;
+} C3D_ProfileScope;
+
+/**
+ * @brief Enables or disables GPU scope profiling.
+ *
+ * Each queue entry completion is timestamped from the GSP interrupt
+ * callbacks. Scopes of a frame are resolved at the next C3D_FrameBegin,
+ * once the GPU has finished with it. Scopes of a frame in which the queue
+ * had to be emptied early (see C3D_QueueStats) are dropped.
+ * @note This takes over the gsp event callbacks of PSC0, PSC1, PPF, P3D and DMA,
+ *       replacing any the application set, and clears them when disabled.
+ *       libctru offers no way to chain to a previous callback.
+ */
+void C3D_ProfileEnable(bool enable);
+
+/**
+ * @brief Opens a named GPU timing scope.
+ * @param[in] name Scope name. The pointer is kept, so it must stay valid (e.g. a string literal).
+ * @note Opening and closing a scope splits the command list so its work is timed on its own.
+ */
+void C3D_ProfileBegin(const char* name);
+void C3D_ProfileEnd(void);
+
+int C3D_ProfileCount(void);
+const C3D_ProfileScope* C3D_ProfileGet(int id);
+const C3D_ProfileScope* C3D_ProfileFind(const char* name);
+void C3D_ProfileReset(void);
@@ -0,0 +1,86 @@
+#pragma once
+#include "uniforms.h"
+#include "attribs.h"
+#include "buffers.h"
+#include "base.h"
+#include "texenv.h"
+#include "texture.h"
+#include "renderqueue.h"
+
+typedef void (* C3D_RecFunc)(const void* data);
+
+/**
+ * @brief Destination of recorded C3D calls (a render thread or a command list).
+ *
+ * Pointers passed to the C3D_Rec* functions (programs, textures, render targets,
+ * index and vertex data, command lists) are kept as is and must stay valid until
+ * the call is replayed. Structures (attribute, buffer and TexEnv info, matrices,
+ * C3D_RecCall data) are copied.
+ */
+typedef struct C3D_Recorder C3D_Recorder;
+struct C3D_Recorder
+{
+	void* (* begin)(C3D_Recorder* rec, u16 op, size_t size); ///< Returns NULL if the packet cannot be recorded
+	void (* commit)(C3D_Recorder* rec);
+};
+
+/**
+ * @brief Secondary command list.
+ *
+ * Recording only touches the list itself, so several lists can be recorded at
+ * once on different threads, one thread per list. The lists are then replayed in
+ * the desired order on the thread owning the citro3d context, by C3D_CmdListExecute
+ * or by recording them into a render thread with C3D_RecCmdList.
+ *
+ * A list has no state of its own: it starts with whatever state is current where
+ * it is replayed, and the state it sets stays in effect after it. Lists replayed
+ * after one another thus inherit from each other in replay order, so each list
+ * should set all the state its draws depend on.
+ */
+typedef struct
+{
+	C3D_Recorder rec;
+	u8* buf;
+	u32 size, used, reserve;
+	u32 packets;
+	bool overflow; // A packet was dropped because the list could not grow
+} C3D_CmdList;
+
+/// Initializes an empty command list, reserving initialSize bytes (0 to allocate on first use).
+bool C3D_CmdListInit(C3D_CmdList* list, u32 initialSize);
+void C3D_CmdListFree(C3D_CmdList* list);
+
+/// Empties the list for recording the next frame, keeping its memory.
+void C3D_CmdListReset(C3D_CmdList* list);
+
+/// Replays the list on the calling thread, which must own the citro3d context.
+void C3D_CmdListExecute(const C3D_CmdList* list);
+
+/// Splices a recorded list into another recorder, without copying it.
+void C3D_RecCmdList(C3D_Recorder* rec, const C3D_CmdList* list);
+
+void C3D_RecFrameBegin(C3D_Recorder* rec, u8 flags);
+void C3D_RecFrameDrawOn(C3D_Recorder* rec, C3D_RenderTarget* target);
+void C3D_RecFrameEnd(C3D_Recorder* rec, u8 flags);
+void C3D_RecRenderTargetClear(C3D_Recorder* rec, C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+
+void C3D_RecBindProgram(C3D_Recorder* rec, shaderProgram_s* program);
+void C3D_RecSetAttrInfo(C3D_Recorder* rec, const C3D_AttrInfo* info);
+void C3D_RecSetBufInfo(C3D_Recorder* rec, const C3D_BufInfo* info);
+void C3D_RecSetTexEnv(C3D_Recorder* rec, int id, const C3D_TexEnv* env);
+void C3D_RecTexBind(C3D_Recorder* rec, int unitId, C3D_Tex* tex);
+
+void C3D_RecFVUnifMtxNx4(C3D_Recorder* rec, GPU_SHADER_TYPE type, int id, const C3D_Mtx* mtx, int num);
+void C3D_RecFVUnifSet(C3D_Recorder* rec, GPU_SHADER_TYPE type, int id, float x, float y, float z, float w);
+
+void C3D_RecDrawArrays(C3D_Recorder* rec, GPU_Primitive_t primitive, int first, int size);
+void C3D_RecDrawElements(C3D_Recorder* rec, GPU_Primitive_t primitive, int count, int type, const void* indices);
+
+/**
+ * @brief Records a call to an arbitrary function.
+ * @param[in] func Function, called with a pointer to the copied data.
+ * @param[in] data Data copied into the packet, may be NULL.
+ * @param[in] size Data size in bytes.
+ * @note Covers any state not recorded by a dedicated function (depth test, blending, fog...).
+ */
+void C3D_RecCall(C3D_Recorder* rec, C3D_RecFunc func, const void* data, size_t size);
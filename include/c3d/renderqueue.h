@@ -15,8 +15,38 @@ struct C3D_RenderTarget_tag
 	gfxScreen_t screen;
 	gfx3dSide_t side;
 	u32 transferFlags;
+
+	bool trackDirty;
+	u16 dirtyY0, dirtyY1; // Dirty band in window rows (as for the scissor), empty when dirtyY0 >= dirtyY1
+
+	bool transient;
+
+	bool dynamicRes;
+	u8 resLevel;
+	u8 resHighest, resLowest; // Level range of a dynamic resolution target
+	u16 resUnder;
+	u16 outWidth, outHeight;  // Output size of a dynamic resolution target
+	u16 resWidth, resHeight;  // Viewport size at the current level
+	void* resColorBuf;        // Full size color buffer, drawn to at C3D_RES_1X1 and above
+	C3D_Tex* resTex;          // Reduced frame, drawn to below C3D_RES_1X1
+	float resBudget;
+
+	bool depthAlternate;
+	bool depthValid;  // Depth cleared at least once since alternation was enabled
+	bool depthDrawn;  // Drawn on since the last clear
+	u8 depthPhase;    // 0: direct half of the depth range, 1: mirrored half
 };
 
+// Resolution levels of dynamic resolution render targets, from highest to lowest
+typedef enum
+{
+	C3D_RES_2X2, // Rendered at twice the output size on both axes, downscaled with GX_TRANSFER_SCALE_XY
+	C3D_RES_2X1, // Rendered at twice the output width, downscaled with GX_TRANSFER_SCALE_X
+	C3D_RES_1X1, // Rendered at the output size
+	C3D_RES_HALF_X,  // Rendered at half the output width, upscaled by the C3D_UpscaleFunc
+	C3D_RES_HALF_XY, // Rendered at half the output size on both axes, upscaled likewise
+} C3D_ResLevel;
+
 // Flags for C3D_FrameBegin
 enum
 {
@@ -24,17 +54,99 @@ enum
 	C3D_FRAME_NONBLOCK = BIT(1), // Return false instead of waiting if the GPU is busy
 };
 
+typedef enum
+{
+	C3D_PACING_NONE,     // Frames start as soon as C3D_FrameSync returns
+	C3D_PACING_LATENCY,  // C3D_FrameSync delays the frame start so it completes just before VBlank
+	C3D_PACING_ADAPTIVE, // As above, additionally switching between the C3D_FrameRate rate and half of it with hysteresis
+} C3D_PacingMode;
+
 float C3D_FrameRate(float fps);
 void C3D_FrameSync(void);
+
+/**
+ * @brief Configures frame pacing.
+ * @param[in] mode     Pacing mode.
+ * @param[in] marginMs Safety margin kept before VBlank, in milliseconds.
+ * @note The delay is applied inside C3D_FrameSync, using the longest CPU+GPU time of the
+ *       last few frames. For the latency gain, sample input after C3D_FrameSync (or after
+ *       C3D_FrameBegin with C3D_FRAME_SYNCDRAW) rather than before.
+ * @note Changing the mode restarts the adaptation from the rate set with C3D_FrameRate,
+ *       which adaptive pacing never overwrites.
+ */
+void C3D_FramePacing(C3D_PacingMode mode, float marginMs);
 u32 C3D_FrameCounter(int id);
 
 bool C3D_FrameBegin(u8 flags);
+
+/**
+ * @brief Selects the render target to draw on.
+ * @return false outside a frame, or if the target tracks dirty regions and has none;
+ *         drawing can then be skipped, as everything would be scissored away.
+ */
 bool C3D_FrameDrawOn(C3D_RenderTarget* target);
 void C3D_FrameSplit(u8 flags);
 void C3D_FrameEnd(u8 flags);
 
+/**
+ * @brief Submits the recorded part of a frame early once a threshold is crossed.
+ * @param[in] words Command buffer words since the last split, 0 to disable.
+ * @param[in] draws Draw calls since the last split, 0 to disable.
+ * @note The first automatic split starts the GPU before C3D_FrameEnd, so it works on
+ *       earlier draws while the CPU keeps recording. The linear heap is flushed once at
+ *       that point. Afterwards, each split only flushes its own command list and the
+ *       ranges recorded with C3D_FlushRange: other data written by the CPU from then on
+ *       must be reported that way (see C3D_FlushTracking) or flushed by the application.
+ */
+void C3D_FrameAutoSplit(u32 words, u32 draws);
+
 void C3D_FrameEndHook(void (* hook)(void*), void* param);
 
+typedef struct
+{
+	u32 epoch; // Queue generation the fence was inserted in
+	u16 entry; // Number of queue entries that must complete
+} C3D_Fence;
+
+/// Returns a fence that is already signaled, for work needing nothing from the GPU.
+static inline C3D_Fence C3D_FenceNone(void)
+{
+	C3D_Fence fence = { 0, 0 }; // No entries to wait for, in any epoch
+	return fence;
+}
+
+/**
+ * @brief Inserts a fence after all GPU work submitted so far.
+ * @note Within a frame, this splits the command list so preceding draws are covered.
+ */
+C3D_Fence C3D_FenceInsert(void);
+bool C3D_FenceSignaled(C3D_Fence fence);
+
+/**
+ * @brief Waits for a fence.
+ * @param[in] fence   Fence returned by C3D_FenceInsert.
+ * @param[in] timeout Timeout in nanoseconds, 0 to poll, -1 to wait forever.
+ * @return true if the fence was reached.
+ * @note Waiting inside a frame starts the GPU on the commands submitted so far.
+ */
+bool C3D_FenceWait(C3D_Fence fence, s64 timeout);
+
+/**
+ * @brief Frees a linear or VRAM buffer once the GPU work submitted so far has completed.
+ * @note Inside a frame, the buffer is kept until the whole frame has completed.
+ *       Deferred frees are processed at C3D_FrameBegin.
+ */
+void C3D_FreeDeferred(void* ptr);
+
+/// Frees a linear or VRAM buffer once a fence has been reached.
+void C3D_FreeAfter(C3D_Fence fence, void* ptr);
+
+/**
+ * @brief Processes deferred frees whose GPU work has completed.
+ * @return Number of deferred frees still pending.
+ */
+size_t C3D_DeferredCollect(void);
+
 float C3D_GetDrawingTime(void);
 float C3D_GetProcessingTime(void);
 
@@ -61,7 +173,87 @@ public:
 
 C3D_RenderTarget* C3D_RenderTargetCreate(int width, int height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt);
 C3D_RenderTarget* C3D_RenderTargetCreateFromTex(C3D_Tex* tex, GPU_TEXFACE face, int level, C3D_DEPTHTYPE depthFmt);
+
+/**
+ * @brief Creates a render target whose resolution follows the GPU load.
+ * @param[in] width   Output width, as passed to C3D_RenderTargetCreate for the same screen.
+ * @param[in] height  Output height.
+ * @param[in] highest Highest level, from C3D_RES_2X2 to C3D_RES_1X1.
+ * @param[in] lowest  Lowest level, from C3D_RES_1X1 to C3D_RES_HALF_XY.
+ *
+ * The target starts at C3D_RES_1X1, with VRAM allocated for the highest level. At each
+ * C3D_FrameBegin the level is picked from the measured GPU time within the given range:
+ * - Above C3D_RES_1X1, the framebuffer dimensions grow inside the allocation, and the
+ *   display transfer downscales back to the output size.
+ * - Below C3D_RES_1X1, the frame is drawn with a reduced viewport into a separate texture,
+ *   and upscaled at C3D_FrameEnd by the C3D_UpscaleFunc. These levels are skipped while no
+ *   such callback is set.
+ *
+ * Since C3D_FrameDrawOn sets the viewport to the active size and all levels map to the
+ * same clip space, no projection change is needed.
+ * @note The target is meant to be cleared every frame, as switching level reinterprets its contents.
+ * @return NULL if allocation fails, or if the reduced frame (power of two sized) would not
+ *         fit the depth buffer.
+ */
+C3D_RenderTarget* C3D_RenderTargetCreateDynamic(int width, int height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt, C3D_ResLevel highest, C3D_ResLevel lowest);
+
+/**
+ * @brief Callback drawing the reduced frame of a dynamic resolution target at full size.
+ * @param[in] tex   Reduced frame; its region [0,u]x[0,v] must cover the whole viewport.
+ * @param[in] u,v   Texture coordinates of the far corner of the drawn region.
+ * @param[in] param User parameter.
+ * @note Called within C3D_FrameEnd with the full size color buffer bound (without depth
+ *       buffer) and the scissor disabled. citro3d has no shader of its own, so the quad is
+ *       drawn by the application. The callback may change any state but the render target.
+ */
+typedef void (* C3D_UpscaleFunc)(C3D_Tex* tex, float u, float v, void* param);
+
+/// Sets the callback upscaling reduced dynamic resolution frames, or NULL to disable those levels.
+void C3D_SetUpscaleFunc(C3D_UpscaleFunc func, void* param);
+
+/**
+ * @brief Sets the GPU time budget driving a dynamic resolution target.
+ * @param[in] gpuMs Budget in milliseconds; 0 keeps the current level.
+ * @note The level drops as soon as a frame goes over budget, and only rises again once
+ *       the doubled cost of the next level has fit the budget for a while.
+ */
+void C3D_RenderTargetResBudget(C3D_RenderTarget* target, float gpuMs);
+
+/// Forces the level of a dynamic resolution target within its range; call outside of a frame.
+void C3D_RenderTargetResLevel(C3D_RenderTarget* target, C3D_ResLevel level);
+
+static inline C3D_ResLevel C3D_RenderTargetGetResLevel(const C3D_RenderTarget* target)
+{
+	return (C3D_ResLevel)target->resLevel;
+}
+
+
+/**
+ * @brief Acquires a transient render target from the pool.
+ *
+ * Pool VRAM blocks are shared by transient targets whose lifetimes do not overlap:
+ * a block released during a frame can back a target acquired later in the same frame.
+ * Blocks unused for a while are returned to VRAM.
+ * @note The target is released at the latest by C3D_FrameEnd, and must not be kept
+ *       across frames. Its contents are undefined when acquired.
+ * @note Releasing a target inside a frame splits the command list, so everything drawn
+ *       so far, including passes sampling the target, is queued before any clear or
+ *       draw by the next owner of its blocks.
+ */
+C3D_RenderTarget* C3D_RenderTargetAcquire(int width, int height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt);
+void C3D_RenderTargetRelease(C3D_RenderTarget* target);
+
+/// Returns the pool VRAM blocks not currently backing a transient target to VRAM.
+void C3D_RenderTargetPoolTrim(void);
+
 void C3D_RenderTargetDelete(C3D_RenderTarget* target);
+
+/**
+ * @brief Deletes a render target without waiting for the GPU.
+ * @note The target is detached from its output immediately and destroyed once the
+ *       GPU is done with it. Unlike C3D_RenderTargetDelete, this may be called inside a frame.
+ */
+void C3D_RenderTargetDeleteDeferred(C3D_RenderTarget* target);
 void C3D_RenderTargetSetOutput(C3D_RenderTarget* target, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags);
 
 static inline void C3D_RenderTargetDetachOutput(C3D_RenderTarget* target)
@@ -69,11 +261,134 @@ static inline void C3D_RenderTargetDetachOutput(C3D_RenderTarget* target)
 	C3D_RenderTargetSetOutput(NULL, target->screen, target->side, 0);
 }
 
-static inline void C3D_RenderTargetClear(C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+/**
+ * @brief Clears a render target.
+ * @note With dirty tracking, only the dirty band is cleared.
+ */
+void C3D_RenderTargetClear(C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+
+/**
+ * @brief Callback drawing a quad over the current scissor to clear it.
+ * @param[in] clearBits  Buffers to clear; the callback sets the write masks accordingly.
+ * @param[in] clearColor Color to write.
+ * @param[in] clearDepth Depth to write.
+ * @param[in] param      User parameter.
+ * @note citro3d has no shader of its own, so quads are drawn by the application.
+ *       The callback may change any state but the scissor and the render target.
+ */
+typedef void (* C3D_ClearQuadFunc)(C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, void* param);
+
+/// Sets the callback used by C3D_RenderTargetClearRect for unaligned edges, or NULL to disable them.
+void C3D_SetClearQuadFunc(C3D_ClearQuadFunc func, void* param);
+
+/**
+ * @brief Clears a rectangle of a render target.
+ * @param[in] x,y,w,h Rectangle in window coordinates, as used by the viewport and scissor.
+ * @return false if the rectangle could not be cleared, in which case nothing is done.
+ *         Depth rectangles of targets with depth alternation are always refused.
+ *
+ * The part of the rectangle aligned to the framebuffer tiles is cleared with memory
+ * fills, one span per tile row. The framebuffer is stored bottom-up, so tile rows are
+ * counted from the bottom of the window. The unaligned edges, if any, are cleared by
+ * the quad callback, one scissored call per edge strip. That requires being inside a
+ * frame; the target, viewport and scissor bound before are restored afterwards, and
+ * the target counts as drawn on.
+ * @note Within a frame, the draws recorded so far are submitted first so they land
+ *       before the fills.
+ */
+bool C3D_RenderTargetClearRect(C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 x, u16 y, u16 w, u16 h);
+
+/**
+ * @brief Enables depth range alternation, which removes most depth clears of a target.
+ *
+ * Depth is mapped into one half of the depth range, and into the other half, mirrored
+ * along with the depth test function, after each clear. Depth left over from the
+ * previous frame is then always behind what is drawn, so C3D_RenderTargetClear and
+ * C3D_ClearTargets only fill the depth buffer the first time. The depth mapping and
+ * test are adjusted at C3D_FrameDrawOn, or at the clear if the target is bound; the
+ * values set by the application are kept. C3D_RenderTargetClearRect refuses to clear
+ * depth on such a target.
+ * @note Every pixel must be written to the depth buffer every frame (e.g. by a sky),
+ *       and depth tests must use LESS, LEQUAL, GREATER or GEQUAL, consistently with
+ *       the clear value. Depth precision is halved. Early depth is not adjusted.
+ * @return false if enabling on a GPU_RB_DEPTH24_STENCIL8 target: the depth fill also
+ *         clears stencil, which would then never be cleared again.
+ */
+bool C3D_RenderTargetDepthAlternate(C3D_RenderTarget* target, bool enable);
+
+/**
+ * @brief Clears several render targets with as few memory fills as possible.
+ * @param[in] targets Render targets, NULL entries are skipped.
+ * @param[in] count   Number of entries in targets.
+ *
+ * Each memory fill has two buffer slots run by separate fill units. The color and
+ * depth buffers of all targets are packed two by two into fills, regardless of which
+ * target they belong to. Within a frame, the fills are queued ahead of the command
+ * list, so they complete before the next draws.
+ */
+void C3D_ClearTargets(C3D_RenderTarget* const targets[], int count, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+
+/**
+ * @brief Enables dirty region tracking for a render target, for mostly static content.
+ *
+ * Only the dirty band of the target is cleared and drawn to (through the scissor),
+ * and a target with nothing dirty is neither transferred nor swapped to its screen,
+ * which keeps showing the previous image. The target starts out fully dirty.
+ * When one eye of a stereo pair is redrawn, a clean tracked other eye is transferred too.
+ */
+void C3D_RenderTargetTrackDirty(C3D_RenderTarget* target, bool enable);
+
+/**
+ * @brief Marks rows [y, y+h) of a tracked render target for redrawing.
+ * @param[in] y,h Rows in window coordinates, as used by the viewport and scissor.
+ * @note Dirty bands always cover the full framebuffer width, and are widened to whole
+ *       tile rows (8 pixels, 32 with block32), which is what a single memory fill can
+ *       clear. The framebuffer is stored bottom-up, so tile rows start from the bottom.
+ */
+void C3D_RenderTargetMarkDirty(C3D_RenderTarget* target, u16 y, u16 h);
+
+static inline bool C3D_RenderTargetIsDirty(const C3D_RenderTarget* target)
 {
-	C3D_FrameBufClear(&target->frameBuf, clearBits, clearColor, clearDepth);
+	return !target->trackDirty || target->dirtyY0 < target->dirtyY1;
 }
 
+typedef struct
+{
+	u16 depth;     // Queue capacity, see C3D_InitEx
+	u16 used;      // Entries used by the current or last frame
+	u16 peak;      // Highest occupancy since the last reset
+	u32 merged;    // Fills and texture copies merged into the previous queue entry
+	u32 fullWaits; // Times the queue was full and had to be drained
+} C3D_QueueStats;
+
+/**
+ * @brief Retrieves GX queue occupancy statistics.
+ * @note Within a frame, single-buffer fills (e.g. clears) issued back to back are merged
+ *       into one two-buffer fill, and contiguous linear texture copies into a single copy.
+ */
+void C3D_GetQueueStats(C3D_QueueStats* stats);
+void C3D_ResetQueueStats(void);
+
 void C3D_SyncDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags);
 void C3D_SyncTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags);
 void C3D_SyncMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* buf1a, u32 buf1v, u32* buf1e, u16 control1);
+
+/**
+ * @brief Asynchronous versions of the C3D_Sync* transfer functions.
+ * @return Fence reached once the transfer has completed.
+ * @note The operation is appended to the GPU queue without waiting for it to drain, so
+ *       several of them can be issued back to back and waited for with the last fence.
+ *       Outside a frame they first wait for the previous frame's GPU work, so that its
+ *       buffer swap and timing are not delayed, then start right away.
+ *       Source data in linear memory must have been flushed beforehand.
+ */
+C3D_Fence C3D_AsyncDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags);
+C3D_Fence C3D_AsyncTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags);
+C3D_Fence C3D_AsyncMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* buf1a, u32 buf1v, u32* buf1e, u16 control1);
+
+/**
+ * @brief Asynchronous version of C3D_TexLoadImage.
+ * @note The source data is flushed, and must stay valid until the fence is reached.
+ *       Linear textures are copied by the CPU right away, and return C3D_FenceNone.
+ */
+C3D_Fence C3D_TexLoadImageAsync(C3D_Tex* tex, const void* data, GPU_TEXFACE face, int level);
@@ -0,0 +1,36 @@
+#pragma once
+#include "recorder.h"
+#include "packetqueue.h"
+
+/**
+ * @brief Render thread replaying recorded C3D calls.
+ *
+ * While the render thread runs, it owns the citro3d context: the game thread
+ * must only record calls through &rt->rec until C3D_RenderThreadStop. Pointers
+ * passed to the C3D_Rec* functions must stay valid until C3D_RenderThreadSync.
+ */
+typedef struct
+{
+	C3D_Recorder rec;
+	C3D_PacketQueue queue;
+	void* buf;
+	Thread thread;
+	LightEvent wake;  // Signaled by the game thread when a packet is committed
+	LightEvent space; // Signaled by the render thread when it has drained the queue
+	bool quit;
+	u32 stalls;       // Times the game thread had to wait for queue space
+} C3D_RenderThread;
+
+/**
+ * @brief Starts a render thread.
+ * @param[in] queueSize Packet queue size in bytes, a power of two.
+ * @param[in] prio      Thread priority.
+ * @param[in] core      Core to run on (e.g. 1 on the system core, or 2 on New 3DS).
+ */
+bool C3D_RenderThreadStart(C3D_RenderThread* rt, u32 queueSize, int prio, int core);
+
+/// Replays the remaining packets, then stops the render thread.
+void C3D_RenderThreadStop(C3D_RenderThread* rt);
+
+/// Waits until every recorded packet has been replayed.
+void C3D_RenderThreadSync(C3D_RenderThread* rt);
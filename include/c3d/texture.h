@@ -58,6 +58,12 @@ void C3D_TexBind(int unitId, C3D_Tex* tex);
 void C3D_TexFlush(C3D_Tex* tex);
 void C3D_TexDelete(C3D_Tex* tex);
 
+/**
+ * @brief Deletes a texture once the GPU can no longer be reading from it.
+ * @note The C3D_Tex (and C3D_TexCube) structures may be reused right away.
+ */
+void C3D_TexDeleteDeferred(C3D_Tex* tex);
+
 void C3D_TexShadowParams(bool perspective, float bias);
 
 static inline int C3D_TexCalcMaxLevel(u32 width, u32 height)
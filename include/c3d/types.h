@@ -5,7 +5,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 typedef uint8_t u8;
+typedef uint16_t u16;
 typedef uint32_t u32;
+typedef int32_t s32;
 #endif
 
 #ifndef CITRO3D_NO_DEPRECATION
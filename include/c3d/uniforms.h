@@ -76,3 +76,31 @@ static inline void C3D_BoolUnifSet(GPU_SHADER_TYPE type, int id, bool value)
 }
 
 void C3D_UpdateUniforms(GPU_SHADER_TYPE type);
+
+#define C3D_FVUNIF_LATCH_COUNT 4
+
+/**
+ * @brief Late latch callback.
+ * @param[in,out] data  Uniform values as recorded in the command buffer, to be replaced in place.
+ * @param[in]     size  Number of vectors in the range.
+ * @param[in]     param User parameter.
+ */
+typedef void (* C3D_FVUnifLatchFunc)(C3D_FVec* data, int size, void* param);
+
+/**
+ * @brief Marks a float uniform range as late latched.
+ * @param[in] type  Shader type.
+ * @param[in] id    First uniform register.
+ * @param[in] size  Number of registers in the range.
+ * @param[in] func  Callback patching the range, or NULL to remove the latch.
+ * @param[in] param User parameter passed to the callback.
+ * @return false if all latch slots are in use, or if the range overlaps another latched range.
+ *
+ * Whenever the range is uploaded, its command words are recorded. When the
+ * command list is handed to the GPU by C3D_FrameSplit or C3D_FrameEnd, func
+ * is called once per upload and its output overwrites the recorded words.
+ * This allows sampling input state at the last moment before submission.
+ * Up to 64 uploads are recorded per command list; the 65th splits the frame
+ * first, submitting the earlier ones.
+ */
+bool C3D_FVUnifLateLatch(GPU_SHADER_TYPE type, int id, int size, C3D_FVUnifLatchFunc func, void* param);
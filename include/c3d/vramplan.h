@@ -0,0 +1,91 @@
+#pragma once
+#include "renderqueue.h"
+
+#define C3D_VRAMPLAN_MAX_ITEMS 32
+
+typedef enum
+{
+	C3D_VRAM_COLOR,
+	C3D_VRAM_DEPTH,
+	C3D_VRAM_TEX,
+} C3D_VramItemKind;
+
+typedef struct
+{
+	u32 size;
+	u32 groups;  // Access groups, see C3D_VramPlanTarget
+	u8 kind;     // C3D_VramItemKind
+	u8 bank;     // VRAM_ALLOC_A or VRAM_ALLOC_B, once solved
+	s8 depth;    // Depth item of a color item, or -1
+	void* mem;
+	union
+	{
+		struct
+		{
+			u16 width, height;
+			GPU_COLORBUF colorFmt;
+			GPU_DEPTHBUF depthFmt;
+			C3D_RenderTarget* target;
+		} rt;
+		struct
+		{
+			C3D_Tex* tex;
+			C3D_TexInitParams params;
+		} tex;
+	};
+} C3D_VramItem;
+
+typedef struct
+{
+	C3D_VramItem items[C3D_VRAMPLAN_MAX_ITEMS];
+	int numItems;
+	u32 conflictBytes; // Bytes sharing a bank with a buffer of the same access group, once committed
+} C3D_VramPlan;
+
+typedef struct
+{
+	u32 free[2];     // Free bytes in banks A and B
+	u32 largest[2];  // Largest free block in each bank
+	u16 blocks[2];   // Number of free blocks in each bank (up to 16 are measured)
+	float fragmentation[2]; // 1 - largest/free, 0 when all free space is contiguous
+} C3D_VramStats;
+
+void C3D_VramPlanInit(C3D_VramPlan* plan);
+
+/**
+ * @brief Declares a render target to be placed by the planner.
+ * @param[in] groups Bit mask of access groups. Buffers sharing a group are used at
+ *                   the same time (e.g. a target and the textures drawn onto it), and
+ *                   are spread over both VRAM banks where possible. The color and
+ *                   depth buffers of a target are always kept apart.
+ * @return Plan handle, or -1 if the plan is full.
+ */
+int C3D_VramPlanTarget(C3D_VramPlan* plan, u16 width, u16 height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt, u32 groups);
+
+/**
+ * @brief Declares a VRAM texture to be placed by the planner.
+ * @param[in] tex    Texture, initialized by C3D_VramPlanCommit (2D and shadow 2D only).
+ * @param[in] groups Bit mask of access groups, see C3D_VramPlanTarget.
+ * @return Plan handle, or -1 if the plan is full or the parameters are invalid.
+ */
+int C3D_VramPlanTex(C3D_VramPlan* plan, C3D_Tex* tex, C3D_TexInitParams params, u32 groups);
+
+/**
+ * @brief Assigns banks to all declared buffers, then allocates and creates them.
+ *
+ * Buffers are assigned largest first, each to the bank holding the fewest bytes of its
+ * access groups, within the free space of each bank. Each bank is then allocated largest
+ * first, which keeps free space contiguous. A buffer not fitting in its bank goes to the
+ * other one.
+ * @return false if VRAM ran out, in which case nothing is allocated.
+ */
+bool C3D_VramPlanCommit(C3D_VramPlan* plan);
+
+/// Returns the render target created for a plan handle.
+C3D_RenderTarget* C3D_VramPlanGetTarget(const C3D_VramPlan* plan, int id);
+
+/**
+ * @brief Measures free space and fragmentation of both VRAM banks.
+ * @note This probes the allocator with temporary allocations, and is meant for diagnostics.
+ */
+void C3D_VramGetStats(C3D_VramStats* stats);
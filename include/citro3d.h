@@ -24,10 +24,19 @@ extern "C" {
 #include "c3d/proctex.h"
 #include "c3d/light.h"
 #include "c3d/lightlut.h"
+#include "c3d/lightmgr.h"
+#include "c3d/foglut.h"
 #include "c3d/fog.h"
 
 #include "c3d/framebuffer.h"
 #include "c3d/renderqueue.h"
+#include "c3d/framegraph.h"
+#include "c3d/vramplan.h"
+#include "c3d/recorder.h"
+#include "c3d/packetqueue.h"
+#include "c3d/renderthread.h"
+#include "c3d/profile.h"
+#include "c3d/framestats.h"
 
 #ifdef __cplusplus
 }
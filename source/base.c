@@ -48,6 +48,7 @@ static void C3Di_AptEventHook(APT_HookType hookType, C3D_UNUSED void* param)
 		case APTHOOK_ONRESTORE:
 		{
 			C3Di_RenderQueueEnableVBlank();
+			C3Di_LutCacheReset();
 			ctx->flags |= C3DiF_AttrInfo | C3DiF_BufInfo | C3DiF_Effect | C3DiF_FrameBuf
 				| C3DiF_Viewport | C3DiF_Scissor | C3DiF_Program | C3DiF_VshCode | C3DiF_GshCode
 				| C3DiF_TexAll | C3DiF_TexEnvBuf | C3DiF_TexEnvAll | C3DiF_LightEnv | C3DiF_Gas;
@@ -74,11 +75,16 @@ static void C3Di_AptEventHook(APT_HookType hookType, C3D_UNUSED void* param)
 }
 
 bool C3D_Init(size_t cmdBufSize)
+{
+	return C3D_InitEx(cmdBufSize, C3D_DEFAULT_QUEUE_DEPTH);
+}
+
+bool C3D_InitEx(size_t cmdBufSize, u16 queueDepth)
 {
 	int i;
 	C3D_Context* ctx = C3Di_GetContext();
 
-	if (ctx->flags & C3DiF_Active)
+	if ((ctx->flags & C3DiF_Active) || !queueDepth)
 		return false;
 
 	cmdBufSize = (cmdBufSize + 0xF) &~ 0xF; // 0x10-byte align
@@ -88,7 +94,7 @@ bool C3D_Init(size_t cmdBufSize)
 	if (!ctx->cmdBuf)
 		return false;
 
-	ctx->gxQueue.maxEntries = 32;
+	ctx->gxQueue.maxEntries = queueDepth;
 	ctx->gxQueue.entries = (gxCmdEntry_s*)malloc(ctx->gxQueue.maxEntries*sizeof(gxCmdEntry_s));
 	if (!ctx->gxQueue.entries)
 	{
@@ -127,6 +133,8 @@ bool C3D_Init(size_t cmdBufSize)
 	ctx->fixedAttribDirty = 0;
 	ctx->fixedAttribEverDirty = 0;
 
+	C3Di_LutCacheReset();
+
 	C3Di_RenderQueueInit();
 	aptHook(&hookCookie, C3Di_AptEventHook, NULL);
 
@@ -256,7 +264,7 @@ void C3Di_UpdateContext(void)
 	if ((ctx->flags & C3DiF_FogLut) && (ctx->texEnvBuf&7) != GPU_NO_FOG)
 	{
 		ctx->flags &= ~C3DiF_FogLut;
-		if (ctx->fogLut)
+		if (ctx->fogLut && C3Di_LutNeedsUpload(C3Di_LutSlot_Fog, ctx->fogLut, sizeof(C3D_FogLut)))
 		{
 			GPUCMD_AddWrite(GPUREG_FOG_LUT_INDEX, 0);
 			GPUCMD_AddWrites(GPUREG_FOG_LUT_DATA0, ctx->fogLut->data, 128);
@@ -322,6 +330,7 @@ bool C3Di_SplitFrame(u32** pBuf, u32* pSize)
 	}
 
 	GPUCMD_Split(pBuf, pSize);
+	C3Di_ApplyUniformLatches();
 	u32 totalCmdBufSize = *pBuf + *pSize - ctx->cmdBuf;
 	ctx->cmdBufUsage = (float)totalCmdBufSize / ctx->cmdBufSize;
 	return true;
@@ -0,0 +1,212 @@
+#include "internal.h"
+#include <c3d/base.h>
+#include <c3d/uniforms.h>
+#include <stdlib.h>
+
+struct C3D_ContextState
+{
+	shaderProgram_s* program;
+	C3D_AttrInfo attrInfo;
+	C3D_BufInfo bufInfo;
+	C3D_Effect effect;
+	C3D_LightEnv* lightEnv;
+
+	u32 procTexConfig;
+	C3D_Tex* tex[3];
+	C3D_TexEnv texEnv[6];
+	u32 texEnvBuf, texEnvBufClr;
+	u32 fogClr;
+	const C3D_FogLut* fogLut;
+
+	C3D_ProcTex* procTex;
+	const C3D_ProcTexLut* procTexLut[3];
+	C3D_ProcTexColorLut* procTexColorLut;
+
+	u16 fixedAttribSet;
+	C3D_FVec fixedAttribs[12];
+
+	C3D_FVec fvUnif[2][C3D_FVUNIF_COUNT];
+	C3D_IVec ivUnif[2][C3D_IVUNIF_COUNT];
+	u16 boolUnifs[2];
+};
+
+C3D_ContextState* C3D_ContextStateNew(void)
+{
+	return (C3D_ContextState*)calloc(1, sizeof(C3D_ContextState));
+}
+
+void C3D_ContextStateDelete(C3D_ContextState* state)
+{
+	free(state);
+}
+
+void C3D_ContextSave(C3D_ContextState* state)
+{
+	C3D_Context* ctx = C3Di_GetContext();
+
+	state->program = ctx->program;
+	state->attrInfo = ctx->attrInfo;
+	state->bufInfo = ctx->bufInfo;
+	state->effect = ctx->effect;
+	state->lightEnv = ctx->lightEnv;
+
+	state->procTexConfig = ctx->texConfig & (7<<8);
+	memcpy(state->tex, ctx->tex, sizeof(ctx->tex));
+	memcpy(state->texEnv, ctx->texEnv, sizeof(ctx->texEnv));
+	state->texEnvBuf = ctx->texEnvBuf;
+	state->texEnvBufClr = ctx->texEnvBufClr;
+	state->fogClr = ctx->fogClr;
+	state->fogLut = ctx->fogLut;
+
+	state->procTex = ctx->procTex;
+	memcpy(state->procTexLut, ctx->procTexLut, sizeof(ctx->procTexLut));
+	state->procTexColorLut = ctx->procTexColorLut;
+
+	state->fixedAttribSet = ctx->fixedAttribEverDirty;
+	memcpy(state->fixedAttribs, ctx->fixedAttribs, sizeof(ctx->fixedAttribs));
+
+	memcpy(state->fvUnif, C3D_FVUnif, sizeof(C3D_FVUnif));
+	memcpy(state->ivUnif, C3D_IVUnif, sizeof(C3D_IVUnif));
+	memcpy(state->boolUnifs, C3D_BoolUnifs, sizeof(C3D_BoolUnifs));
+}
+
+static void C3Di_UniformsRestore(const C3D_ContextState* state, GPU_SHADER_TYPE type)
+{
+	int i;
+	for (i = 0; i < C3D_FVUNIF_COUNT; i ++)
+	{
+		if (memcmp(&C3D_FVUnif[type][i], &state->fvUnif[type][i], sizeof(C3D_FVec)) == 0)
+			continue;
+		C3D_FVUnif[type][i] = state->fvUnif[type][i];
+		C3D_FVUnifDirty[type][i] = true;
+	}
+
+	for (i = 0; i < C3D_IVUNIF_COUNT; i ++)
+	{
+		if (C3D_IVUnif[type][i] == state->ivUnif[type][i])
+			continue;
+		C3D_IVUnif[type][i] = state->ivUnif[type][i];
+		C3D_IVUnifDirty[type][i] = true;
+	}
+
+	if (C3D_BoolUnifs[type] != state->boolUnifs[type])
+	{
+		C3D_BoolUnifs[type] = state->boolUnifs[type];
+		C3D_BoolUnifsDirty[type] = true;
+	}
+}
+
+void C3D_ContextRestore(const C3D_ContextState* state)
+{
+	int i;
+	C3D_Context* ctx = C3Di_GetContext();
+
+	if (!(ctx->flags & C3DiF_Active))
+		return;
+
+	// Binding the program first, as it reloads the shader's constant uniforms
+	if (state->program && state->program != ctx->program)
+		C3D_BindProgram(state->program);
+
+	if (memcmp(&ctx->attrInfo, &state->attrInfo, sizeof(C3D_AttrInfo)) != 0)
+	{
+		ctx->attrInfo = state->attrInfo;
+		ctx->flags |= C3DiF_AttrInfo;
+	}
+
+	if (memcmp(&ctx->bufInfo, &state->bufInfo, sizeof(C3D_BufInfo)) != 0)
+	{
+		ctx->bufInfo = state->bufInfo;
+		ctx->flags |= C3DiF_BufInfo;
+	}
+
+	if (memcmp(&ctx->effect, &state->effect, sizeof(C3D_Effect)) != 0)
+	{
+		ctx->effect = state->effect;
+		ctx->flags |= C3DiF_Effect;
+	}
+
+	if (ctx->lightEnv != state->lightEnv)
+	{
+		ctx->lightEnv = state->lightEnv;
+		ctx->flags |= C3DiF_LightEnv;
+	}
+
+	for (i = 0; i < 3; i ++)
+	{
+		if (ctx->tex[i] == state->tex[i])
+			continue;
+		ctx->tex[i] = state->tex[i];
+		ctx->flags |= C3DiF_Tex(i);
+	}
+
+	for (i = 0; i < 6; i ++)
+	{
+		if (memcmp(&ctx->texEnv[i], &state->texEnv[i], sizeof(C3D_TexEnv)) == 0)
+			continue;
+		ctx->texEnv[i] = state->texEnv[i];
+		ctx->flags |= C3DiF_TexEnv(i);
+	}
+
+	if (ctx->texEnvBuf != state->texEnvBuf || ctx->texEnvBufClr != state->texEnvBufClr || ctx->fogClr != state->fogClr)
+	{
+		ctx->texEnvBuf = state->texEnvBuf;
+		ctx->texEnvBufClr = state->texEnvBufClr;
+		ctx->fogClr = state->fogClr;
+		ctx->flags |= C3DiF_TexEnvBuf;
+	}
+
+	if (ctx->fogLut != state->fogLut)
+	{
+		ctx->fogLut = state->fogLut;
+		if (state->fogLut)
+			ctx->flags |= C3DiF_FogLut;
+		else
+			ctx->flags &= ~C3DiF_FogLut;
+	}
+
+	if (ctx->procTex != state->procTex || (ctx->texConfig & (7<<8)) != state->procTexConfig)
+	{
+		ctx->procTex = state->procTex;
+		ctx->texConfig = (ctx->texConfig &~ (7<<8)) | state->procTexConfig;
+		ctx->flags |= C3DiF_TexStatus;
+		if (state->procTex)
+			ctx->flags |= C3DiF_ProcTex;
+		else
+			ctx->flags &= ~C3DiF_ProcTex;
+	}
+
+	for (i = 0; i < 3; i ++)
+	{
+		if (ctx->procTexLut[i] == state->procTexLut[i])
+			continue;
+		ctx->procTexLut[i] = state->procTexLut[i];
+		if (state->procTexLut[i])
+			ctx->flags |= C3DiF_ProcTexLut(i);
+		else
+			ctx->flags &= ~C3DiF_ProcTexLut(i);
+	}
+
+	if (ctx->procTexColorLut != state->procTexColorLut)
+	{
+		ctx->procTexColorLut = state->procTexColorLut;
+		if (state->procTexColorLut)
+			ctx->flags |= C3DiF_ProcTexColorLut;
+		else
+			ctx->flags &= ~C3DiF_ProcTexColorLut;
+	}
+
+	for (i = 0; i < 12; i ++)
+	{
+		if (!(state->fixedAttribSet & BIT(i)))
+			continue;
+		if (memcmp(&ctx->fixedAttribs[i], &state->fixedAttribs[i], sizeof(C3D_FVec)) == 0)
+			continue;
+		ctx->fixedAttribs[i] = state->fixedAttribs[i];
+		ctx->fixedAttribDirty |= BIT(i);
+		ctx->fixedAttribEverDirty |= BIT(i);
+	}
+
+	C3Di_UniformsRestore(state, GPU_VERTEX_SHADER);
+	C3Di_UniformsRestore(state, GPU_GEOMETRY_SHADER);
+}
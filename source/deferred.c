@@ -0,0 +1,120 @@
+#include "internal.h"
+#include <c3d/renderqueue.h>
+#include <stdlib.h>
+
+enum
+{
+	C3Di_Deferred_Buffer,
+	C3Di_Deferred_Target,
+};
+
+typedef struct
+{
+	C3D_Fence fence;
+	u8 kind;
+	bool pending; // Used by the current frame; fenced at C3D_FrameEnd
+	void* ptr;
+} C3Di_DeferredEntry;
+
+static C3Di_DeferredEntry* deferred;
+static size_t numDeferred, maxDeferred;
+
+static void C3Di_DeferredRelease(u8 kind, void* ptr)
+{
+	if (kind == C3Di_Deferred_Target)
+		C3Di_RenderTargetDestroy((C3D_RenderTarget*)ptr);
+	else
+		allocFree(ptr);
+}
+
+static void C3Di_DeferredPush(u8 kind, void* ptr, const C3D_Fence* fence)
+{
+	if (!ptr)
+		return;
+
+	if (numDeferred == maxDeferred)
+	{
+		size_t newMax = maxDeferred ? 2*maxDeferred : 32;
+		C3Di_DeferredEntry* newDeferred = (C3Di_DeferredEntry*)realloc(deferred, newMax*sizeof(C3Di_DeferredEntry));
+		if (!newDeferred)
+		{
+			// Out of memory: fall back to waiting for the GPU
+			C3D_FenceWait(fence ? *fence : C3D_FenceInsert(), -1);
+			C3Di_DeferredRelease(kind, ptr);
+			return;
+		}
+		deferred = newDeferred;
+		maxDeferred = newMax;
+	}
+
+	C3Di_DeferredEntry* e = &deferred[numDeferred++];
+	e->kind = kind;
+	e->ptr = ptr;
+	e->pending = !fence && C3Di_InFrame();
+	if (fence)
+		e->fence = *fence;
+	else if (!e->pending)
+		e->fence = C3D_FenceInsert();
+}
+
+void C3D_FreeDeferred(void* ptr)
+{
+	C3Di_DeferredPush(C3Di_Deferred_Buffer, ptr, NULL);
+}
+
+void C3D_FreeAfter(C3D_Fence fence, void* ptr)
+{
+	C3Di_DeferredPush(C3Di_Deferred_Buffer, ptr, &fence);
+}
+
+void C3Di_DeferredRenderTarget(C3D_RenderTarget* target)
+{
+	C3Di_DeferredPush(C3Di_Deferred_Target, target, NULL);
+}
+
+void C3Di_DeferredFrameEnd(void)
+{
+	size_t i;
+	bool haveFence = false;
+	C3D_Fence fence;
+
+	for (i = 0; i < numDeferred; i ++)
+	{
+		if (!deferred[i].pending)
+			continue;
+		if (!haveFence)
+		{
+			fence = C3D_FenceInsert();
+			haveFence = true;
+		}
+		deferred[i].fence = fence;
+		deferred[i].pending = false;
+	}
+}
+
+void C3Di_DeferredCollect(bool all)
+{
+	size_t i, j = 0;
+	for (i = 0; i < numDeferred; i ++)
+	{
+		C3Di_DeferredEntry* e = &deferred[i];
+		if (all || (!e->pending && C3D_FenceSignaled(e->fence)))
+			C3Di_DeferredRelease(e->kind, e->ptr);
+		else
+			deferred[j++] = *e;
+	}
+	numDeferred = j;
+
+	if (all)
+	{
+		free(deferred);
+		deferred = NULL;
+		maxDeferred = 0;
+	}
+}
+
+size_t C3D_DeferredCollect(void)
+{
+	C3Di_DeferredCollect(false);
+	return numDeferred;
+}
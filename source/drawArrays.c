@@ -28,4 +28,5 @@ void C3D_DrawArrays(GPU_Primitive_t primitive, int first, int size)
 	GPUCMD_AddWrite(GPUREG_VTX_FUNC, 1);
 
 	C3Di_GetContext()->flags |= C3DiF_DrawUsed;
+	C3Di_FrameDrawDone();
 }
@@ -43,4 +43,5 @@ void C3D_DrawElements(GPU_Primitive_t primitive, int count, int type, const void
 	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x8, 0);
 
 	C3Di_GetContext()->flags |= C3DiF_DrawUsed;
+	C3Di_FrameDrawDone();
 }
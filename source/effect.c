@@ -13,6 +13,8 @@ void C3D_DepthMap(bool bIsZBuffer, float zScale, float zOffset)
 	e->zBuffer = bIsZBuffer;
 	e->zScale  = f32tof24(zScale);
 	e->zOffset = f32tof24(zOffset);
+	e->zScaleF  = zScale;
+	e->zOffsetF = zOffset;
 }
 
 void C3D_CullFace(GPU_CULLMODE mode)
@@ -89,11 +91,34 @@ void C3D_FragOpShadow(float scale, float bias)
 
 void C3Di_EffectBind(C3D_Effect* e)
 {
+	u32 depthMap[2] = { e->zScale, e->zOffset };
+	u32 fragTests[4] = { e->alphaTest, e->stencilMode, e->stencilOp, e->depthTest };
+	u8 depthPhase = C3Di_GetContext()->depthPhase;
+
+	if (depthPhase)
+	{
+		// Squeeze depth into the half that old depth from the other half is behind of
+		u32 func = (e->depthTest>>4) & 7;
+		bool greater = func >= GPU_GREATER;
+		float zScale  = e->zScaleF / 2;
+		float zOffset = e->zOffsetF / 2 + (greater ? 0.5f : 0.0f);
+		if (depthPhase == 2)
+		{
+			// Mirrored: nearer depth now goes the other way
+			zScale  = -zScale;
+			zOffset = 1.0f - zOffset;
+			if (func >= GPU_LESS)
+				fragTests[3] = (e->depthTest &~ (7<<4)) | ((func ^ 2) << 4);
+		}
+		depthMap[0] = f32tof24(zScale);
+		depthMap[1] = f32tof24(zOffset);
+	}
+
 	GPUCMD_AddWrite(GPUREG_DEPTHMAP_ENABLE, e->zBuffer ? 1 : 0);
 	GPUCMD_AddWrite(GPUREG_FACECULLING_CONFIG, e->cullMode & 0x3);
-	GPUCMD_AddIncrementalWrites(GPUREG_DEPTHMAP_SCALE, (u32*)&e->zScale, 2);
-	GPUCMD_AddIncrementalWrites(GPUREG_FRAGOP_ALPHA_TEST, (u32*)&e->alphaTest, 4);
-	GPUCMD_AddMaskedWrite(GPUREG_GAS_DELTAZ_DEPTH, 0x8, (u32)GPU_MAKEGASDEPTHFUNC((e->depthTest>>4)&7) << 24);
+	GPUCMD_AddIncrementalWrites(GPUREG_DEPTHMAP_SCALE, depthMap, 2);
+	GPUCMD_AddIncrementalWrites(GPUREG_FRAGOP_ALPHA_TEST, fragTests, 4);
+	GPUCMD_AddMaskedWrite(GPUREG_GAS_DELTAZ_DEPTH, 0x8, (u32)GPU_MAKEGASDEPTHFUNC((fragTests[3]>>4)&7) << 24);
 	GPUCMD_AddWrite(GPUREG_BLEND_COLOR, e->blendClr);
 	GPUCMD_AddWrite(GPUREG_BLEND_FUNC, e->alphaBlend);
 	GPUCMD_AddWrite(GPUREG_LOGIC_OP, e->clrLogicOp);
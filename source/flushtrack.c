@@ -0,0 +1,88 @@
+#include "internal.h"
+
+#define C3Di_FLUSH_MAX_RANGES 32
+#define C3Di_FLUSH_LINE       32 // Data cache line size
+
+typedef struct
+{
+	u32 start, end;
+} C3Di_FlushRange;
+
+static C3Di_FlushRange ranges[C3Di_FLUSH_MAX_RANGES];
+static int numRanges;
+static size_t flushThreshold;
+
+void C3D_FlushTracking(size_t threshold)
+{
+	flushThreshold = threshold;
+	numRanges = 0;
+}
+
+void C3D_FlushRange(const void* addr, size_t size)
+{
+	int i, j;
+	if (!flushThreshold || !size)
+		return;
+
+	u32 start = (u32)addr &~ (C3Di_FLUSH_LINE-1);
+	u32 end = ((u32)addr + size + C3Di_FLUSH_LINE-1) &~ (C3Di_FLUSH_LINE-1);
+
+	// Insert sorted, merging with any overlapping or adjacent ranges
+	for (i = 0; i < numRanges && ranges[i].end < start; i ++);
+	for (j = i; j < numRanges && ranges[j].start <= end; j ++)
+	{
+		if (ranges[j].start < start) start = ranges[j].start;
+		if (ranges[j].end > end) end = ranges[j].end;
+	}
+
+	if (j > i)
+	{
+		ranges[i].start = start;
+		ranges[i].end = end;
+		memmove(&ranges[i+1], &ranges[j], (numRanges-j)*sizeof(C3Di_FlushRange));
+		numRanges -= j-i-1;
+		return;
+	}
+
+	if (numRanges == C3Di_FLUSH_MAX_RANGES)
+	{
+		// Out of ranges: merge the two closest ones, then retry
+		int best = 0;
+		for (j = 1; j < numRanges-1; j ++)
+			if (ranges[j+1].start - ranges[j].end < ranges[best+1].start - ranges[best].end)
+				best = j;
+		ranges[best].end = ranges[best+1].end;
+		memmove(&ranges[best+1], &ranges[best+2], (numRanges-best-2)*sizeof(C3Di_FlushRange));
+		numRanges--;
+		C3D_FlushRange((const void*)start, end-start);
+		return;
+	}
+
+	memmove(&ranges[i+1], &ranges[i], (numRanges-i)*sizeof(C3Di_FlushRange));
+	ranges[i].start = start;
+	ranges[i].end = end;
+	numRanges++;
+}
+
+bool C3Di_FlushTrackingEnabled(void)
+{
+	return flushThreshold != 0;
+}
+
+bool C3Di_FlushTracked(void)
+{
+	int i;
+	size_t total = 0;
+	if (!flushThreshold)
+		return false;
+
+	for (i = 0; i < numRanges; i ++)
+		total += ranges[i].end - ranges[i].start;
+
+	if (total <= flushThreshold)
+		for (i = 0; i < numRanges; i ++)
+			GSPGPU_FlushDataCache((const void*)ranges[i].start, ranges[i].end - ranges[i].start);
+
+	numRanges = 0;
+	return total <= flushThreshold;
+}
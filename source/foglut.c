@@ -0,0 +1,85 @@
+#include <c3d/foglut.h>
+
+static inline u32 C3Di_FogLutEntry(float in, float diff)
+{
+	u32 val = 0;
+	if (in > 0.0f)
+	{
+		in *= 0x800;
+		val = (in < 0x800) ? (u32)in : 0x7FF;
+	}
+
+	u32 val2 = 0;
+	if (diff != 0.0f)
+	{
+		diff *= 0x800;
+		if (diff < -0x1000) diff = -0x1000;
+		else if (diff > 0xFFF) diff = 0xFFF;
+		val2 = (s32)diff & 0x1FFF;
+	}
+
+	return val2 | (val << 13);
+}
+
+void FogLut_FromArray(C3D_FogLut* lut, const float data[256])
+{
+	int i;
+	for (i = 0; i < 128; i ++)
+		lut->data[i] = C3Di_FogLutEntry(data[i], data[i+128]);
+}
+
+void FogLut_Exp(C3D_FogLut* lut, float density, float gradient, float near, float far)
+{
+	int i;
+	float data[256];
+	for (i = 0; i <= 128; i ++)
+	{
+		float x = FogLut_CalcZ(i/128.0f, near, far);
+		float val = expf(-powf(density*x, gradient));
+		if (i < 128)
+			data[i] = val;
+		if (i > 0)
+			data[i+127] = val-data[i-1];
+	}
+	FogLut_FromArray(lut, data);
+}
+
+static inline __attribute__((always_inline)) void C3Di_FogLutShape(u32* out, C3D_LutShape shape, float a, float b, float near, float far, int first, int last)
+{
+	int i;
+	float val = C3D_LutShapeEval(shape, FogLut_CalcZ(first/128.0f, near, far), a, b);
+	for (i = first; i < last; i ++)
+	{
+		float next = C3D_LutShapeEval(shape, FogLut_CalcZ((i+1)/128.0f, near, far), a, b);
+		out[i] = C3Di_FogLutEntry(val, next-val);
+		val = next;
+	}
+}
+
+void FogLut_FromShapeRange(C3D_FogLut* lut, C3D_LutShape shape, float a, float b, float near, float far, int first, int count)
+{
+	int last = first+count;
+	if (first < 0) first = 0;
+	if (last > 128) last = 128;
+	if (first >= last)
+		return;
+
+	switch (shape)
+	{
+		case C3D_LUT_POW:
+			C3Di_FogLutShape(lut->data, C3D_LUT_POW, a, b, near, far, first, last);
+			break;
+		case C3D_LUT_EXP:
+			C3Di_FogLutShape(lut->data, C3D_LUT_EXP, a, b, near, far, first, last);
+			break;
+		case C3D_LUT_LINEAR:
+			C3Di_FogLutShape(lut->data, C3D_LUT_LINEAR, a, b, near, far, first, last);
+			break;
+		case C3D_LUT_SMOOTHSTEP:
+			C3Di_FogLutShape(lut->data, C3D_LUT_SMOOTHSTEP, a, b, near, far, first, last);
+			break;
+		case C3D_LUT_QUADRATIC:
+			C3Di_FogLutShape(lut->data, C3D_LUT_QUADRATIC, a, b, near, far, first, last);
+			break;
+	}
+}
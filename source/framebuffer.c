@@ -68,28 +68,139 @@ void C3Di_FrameBufBind(C3D_FrameBuf* fb)
 	GPUCMD_AddIncrementalWrites(GPUREG_COLORBUFFER_READ, param, 4);
 }
 
+// Makes what was drawn so far visible to the texture units
+void C3Di_FrameBufBarrier(void)
+{
+	C3D_Context* ctx = C3Di_GetContext();
+	if (ctx->flags & C3DiF_DrawUsed)
+	{
+		ctx->flags &= ~C3DiF_DrawUsed;
+		GPUCMD_AddWrite(GPUREG_FRAMEBUFFER_FLUSH, 1);
+		GPUCMD_AddWrite(GPUREG_FRAMEBUFFER_INVALIDATE, 1);
+		GPUCMD_AddWrite(GPUREG_EARLYDEPTH_CLEAR, 1);
+	}
+
+	// Make sure the texture units do not sample stale cached texels
+	ctx->texConfig |= BIT(16);
+	ctx->flags |= C3DiF_TexStatus;
+}
+
 void C3D_FrameBufClear(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
 {
-	u32 size = (u32)frameBuf->width * frameBuf->height;
-	u32 cfs = colorFmtSizes[frameBuf->colorFmt];
-	u32 dfs = depthFmtSizes[frameBuf->depthFmt];
-	void* colorBufEnd = (u8*)frameBuf->colorBuf + size*(2+cfs);
-	void* depthBufEnd = (u8*)frameBuf->depthBuf + size*(2+dfs);
+	C3Di_FrameBufClearRows(frameBuf, clearBits, clearColor, clearDepth, 0, frameBuf->height);
+}
+
+// Fill spans covering the pixels [start,end) in storage order
+static int C3Di_FrameBufSpans(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u32 start, u32 end, C3Di_FillSpan spans[2])
+{
+	int count = 0;
+
+	if ((clearBits & C3D_CLEAR_COLOR) && frameBuf->colorBuf)
+	{
+		u32 cfs = colorFmtSizes[frameBuf->colorFmt];
+		spans[count].start   = (u32*)((u8*)frameBuf->colorBuf + start*(2+cfs));
+		spans[count].end     = (u32*)((u8*)frameBuf->colorBuf + end*(2+cfs));
+		spans[count].value   = clearColor;
+		spans[count].control = BIT(0) | (cfs << 8);
+		count++;
+	}
+
+	if ((clearBits & C3D_CLEAR_DEPTH) && frameBuf->depthBuf)
+	{
+		u32 dfs = depthFmtSizes[frameBuf->depthFmt];
+		spans[count].start   = (u32*)((u8*)frameBuf->depthBuf + start*(2+dfs));
+		spans[count].end     = (u32*)((u8*)frameBuf->depthBuf + end*(2+dfs));
+		spans[count].value   = clearDepth;
+		spans[count].control = BIT(0) | (dfs << 8);
+		count++;
+	}
+
+	return count;
+}
+
+// Framebuffers are stored as rows of 8x8 (or 32x32) tiles, so a range of tile rows is contiguous.
+// Storage starts from the bottom of the window: window rows [y0,y1) are stored rows [height-y1,height-y0).
+int C3Di_FrameBufClearSpans(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 y0, u16 y1, C3Di_FillSpan spans[2])
+{
+	u32 tile = C3Di_FrameBufTileSize(frameBuf);
+	u32 start = (u32)frameBuf->width * ((frameBuf->height - y1) &~ (tile-1));
+	u32 end   = (u32)frameBuf->width * ((frameBuf->height - y0 + tile-1) &~ (tile-1));
+	return C3Di_FrameBufSpans(frameBuf, clearBits, clearColor, clearDepth, start, end, spans);
+}
+
+void C3Di_FillPush(C3Di_FillBatch* batch, const C3Di_FillSpan* spans, int count)
+{
+	int i;
+	for (i = 0; i < count; i ++)
+	{
+		if (!batch->havePending)
+		{
+			batch->pending = spans[i];
+			batch->havePending = true;
+			continue;
+		}
+
+		C3Di_QueueMemoryFill(
+			batch->pending.start, batch->pending.value, batch->pending.end, batch->pending.control,
+			spans[i].start, spans[i].value, spans[i].end, spans[i].control);
+		batch->havePending = false;
+	}
+}
+
+void C3Di_FillFlush(C3Di_FillBatch* batch)
+{
+	if (!batch->havePending)
+		return;
 
-	if (clearBits & C3D_CLEAR_COLOR)
+	C3Di_QueueMemoryFill(
+		batch->pending.start, batch->pending.value, batch->pending.end, batch->pending.control,
+		NULL, 0, NULL, 0);
+	batch->havePending = false;
+}
+
+void C3Di_FrameBufClearRows(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 y0, u16 y1)
+{
+	C3Di_FillSpan spans[2];
+	C3Di_FillBatch batch = { .havePending = false };
+	C3Di_FillPush(&batch, spans, C3Di_FrameBufClearSpans(frameBuf, clearBits, clearColor, clearDepth, y0, y1, spans));
+	C3Di_FillFlush(&batch);
+}
+
+bool C3D_FrameBufClearRect(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 x, u16 y, u16 w, u16 h)
+{
+	u32 tile = C3Di_FrameBufTileSize(frameBuf);
+	u32 x1 = (u32)x + w, y1 = (u32)y + h;
+	if (x1 > frameBuf->width)  x1 = frameBuf->width;
+	if (y1 > frameBuf->height) y1 = frameBuf->height;
+	if (x >= x1 || y >= y1)
+		return true;
+
+	// Stored rows, bottom-up; the edges of the buffer count as aligned
+	u32 sy0 = frameBuf->height - y1, sy1 = frameBuf->height - y;
+	if (((x | sy0) & (tile-1)) || (x1 < frameBuf->width && (x1 & (tile-1))) || (sy1 < frameBuf->height && (sy1 & (tile-1))))
+		return false;
+
+	if (x == 0 && x1 == frameBuf->width)
+	{
+		C3Di_FrameBufClearRows(frameBuf, clearBits, clearColor, clearDepth, y, y1);
+		return true;
+	}
+
+	// Each tile row holds its tiles left to right, so the rectangle is one span per tile row
+	u32 rowSize = frameBuf->width * tile;
+	u32 start = (x / tile) * tile * tile;
+	u32 end   = ((x1 + tile-1) / tile) * tile * tile;
+	C3Di_FillSpan spans[2];
+	C3Di_FillBatch batch = { .havePending = false };
+
+	for (; sy0 < sy1; sy0 += tile)
 	{
-		if (clearBits & C3D_CLEAR_DEPTH)
-			GX_MemoryFill(
-				(u32*)frameBuf->colorBuf, clearColor, (u32*)colorBufEnd, BIT(0) | (cfs << 8),
-				(u32*)frameBuf->depthBuf, clearDepth, (u32*)depthBufEnd, BIT(0) | (dfs << 8));
-		else
-			GX_MemoryFill(
-				(u32*)frameBuf->colorBuf, clearColor, (u32*)colorBufEnd, BIT(0) | (cfs << 8),
-				NULL, 0, NULL, 0);
-	} else
-		GX_MemoryFill(
-			(u32*)frameBuf->depthBuf, clearDepth, (u32*)depthBufEnd, BIT(0) | (dfs << 8),
-			NULL, 0, NULL, 0);
+		u32 row = (sy0 / tile) * rowSize;
+		C3Di_FillPush(&batch, spans, C3Di_FrameBufSpans(frameBuf, clearBits, clearColor, clearDepth, row + start, row + end, spans));
+	}
+
+	C3Di_FillFlush(&batch);
+	return true;
 }
 
 void C3D_FrameBufTransfer(C3D_FrameBuf* frameBuf, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags)
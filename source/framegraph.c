@@ -0,0 +1,176 @@
+#include "internal.h"
+#include <c3d/framegraph.h>
+
+void C3D_FrameGraphInit(C3D_FrameGraph* fg)
+{
+	memset(fg, 0, sizeof(*fg));
+}
+
+int C3D_FrameGraphAddPass(C3D_FrameGraph* fg, const char* name, C3D_RenderTarget* output, C3D_PassFunc func, void* param, u8 flags)
+{
+	if (fg->numPasses == C3D_FRAMEGRAPH_MAX_PASSES || !output)
+		return -1;
+
+	C3D_Pass* pass = &fg->passes[fg->numPasses];
+	memset(pass, 0, sizeof(*pass));
+	pass->name   = name;
+	pass->output = output;
+	pass->func   = func;
+	pass->param  = param;
+	pass->flags  = flags;
+	fg->compiled = false;
+	return fg->numPasses++;
+}
+
+bool C3D_FrameGraphPassRead(C3D_FrameGraph* fg, int pass, C3D_RenderTarget* input)
+{
+	if (pass < 0 || pass >= fg->numPasses)
+		return false;
+
+	C3D_Pass* p = &fg->passes[pass];
+	if (p->numInputs == C3D_FRAMEGRAPH_MAX_INPUTS || input == p->output)
+		return false;
+
+	p->inputs[p->numInputs++] = input;
+	fg->compiled = false;
+	return true;
+}
+
+void C3D_FrameGraphPassClear(C3D_FrameGraph* fg, int pass, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	if (pass < 0 || pass >= fg->numPasses)
+		return;
+
+	C3D_Pass* p = &fg->passes[pass];
+	p->clearBits  = clearBits;
+	p->clearColor = clearColor;
+	p->clearDepth = clearDepth;
+	fg->compiled = false;
+}
+
+static bool C3Di_PassReads(const C3D_Pass* p, const C3D_RenderTarget* target)
+{
+	int i;
+	for (i = 0; i < p->numInputs; i ++)
+		if (p->inputs[i] == target)
+			return true;
+	return false;
+}
+
+bool C3D_FrameGraphCompile(C3D_FrameGraph* fg)
+{
+	int i, j, n = fg->numPasses;
+	u16 deps[C3D_FRAMEGRAPH_MAX_PASSES];
+	u16 live = 0, done = 0, written = 0;
+
+	fg->compiled = false;
+	fg->numOrdered = 0;
+	fg->hoistClear = 0;
+	fg->barrier = 0;
+
+	// Pass i depends on pass j if it samples j's output, or draws after j on the same target
+	for (i = 0; i < n; i ++)
+	{
+		const C3D_Pass* p = &fg->passes[i];
+		deps[i] = 0;
+		for (j = 0; j < n; j ++)
+		{
+			const C3D_Pass* q = &fg->passes[j];
+			if (j == i)
+				continue;
+			if (C3Di_PassReads(p, q->output) || (j < i && q->output == p->output))
+				deps[i] |= BIT(j);
+		}
+		if ((p->flags & C3D_PASS_KEEP) || p->output->linked)
+			live |= BIT(i);
+	}
+
+	// Keep everything the kept passes transitively depend on
+	for (;;)
+	{
+		u16 more = live;
+		for (i = 0; i < n; i ++)
+			if (live & BIT(i))
+				more |= deps[i];
+		if (more == live)
+			break;
+		live = more;
+	}
+
+	// Stable topological sort: always run the first declared pass that is ready
+	while (fg->numOrdered < __builtin_popcount(live))
+	{
+		for (i = 0; i < n; i ++)
+			if ((live & BIT(i)) && !(done & BIT(i)) && !(deps[i] & live & ~done))
+				break;
+		if (i == n)
+			return false; // Cycle
+
+		const C3D_Pass* p = &fg->passes[i];
+		fg->order[fg->numOrdered++] = i;
+		done |= BIT(i);
+
+		for (j = 0; j < p->numInputs; j ++)
+		{
+			int k;
+			for (k = 0; k < n; k ++)
+				if ((written & BIT(k)) && fg->passes[k].output == p->inputs[j])
+					fg->barrier |= BIT(i);
+		}
+
+		// A clear of a target nothing has touched yet this frame can move to the start
+		if (p->clearBits)
+		{
+			bool first = true;
+			for (j = 0; j < n; j ++)
+				if ((written & BIT(j)) && (fg->passes[j].output == p->output || C3Di_PassReads(&fg->passes[j], p->output)))
+					first = false;
+			if (first)
+				fg->hoistClear |= BIT(i);
+		}
+		written |= BIT(i);
+	}
+
+	fg->compiled = true;
+	return true;
+}
+
+bool C3D_FrameGraphExecute(C3D_FrameGraph* fg)
+{
+	int i;
+	if (!C3Di_InFrame())
+		return false;
+	if (!fg->compiled && !C3D_FrameGraphCompile(fg))
+		return false;
+
+	// Issue the up-front clears back to back so they share memory fills
+	if (fg->hoistClear)
+	{
+		C3D_FrameSplit(0);
+		for (i = 0; i < fg->numOrdered; i ++)
+		{
+			const C3D_Pass* p = &fg->passes[fg->order[i]];
+			if (fg->hoistClear & BIT(fg->order[i]))
+				C3D_RenderTargetClear(p->output, p->clearBits, p->clearColor, p->clearDepth);
+		}
+	}
+
+	for (i = 0; i < fg->numOrdered; i ++)
+	{
+		int id = fg->order[i];
+		const C3D_Pass* p = &fg->passes[id];
+
+		if (p->clearBits && !(fg->hoistClear & BIT(id)))
+		{
+			// Draws recorded so far must land before the clear
+			C3D_FrameSplit(0);
+			C3D_RenderTargetClear(p->output, p->clearBits, p->clearColor, p->clearDepth);
+		}
+		if (fg->barrier & BIT(id))
+			C3Di_FrameBufBarrier();
+
+		if (C3D_FrameDrawOn(p->output) && p->func)
+			p->func(p->param);
+	}
+	return true;
+}
@@ -0,0 +1,136 @@
+#include "internal.h"
+#include <c3d/framestats.h>
+#include <stdlib.h>
+
+static C3D_FrameStats* history;
+static float* scratch;
+static size_t capacity, count, head;
+
+bool C3D_FrameStatsInit(size_t size)
+{
+	free(history);
+	free(scratch);
+	history = NULL;
+	scratch = NULL;
+	capacity = count = head = 0;
+	if (!size)
+		return true;
+
+	history = (C3D_FrameStats*)malloc(size*sizeof(C3D_FrameStats));
+	scratch = (float*)malloc(size*sizeof(float));
+	if (!history || !scratch)
+	{
+		C3D_FrameStatsInit(0);
+		return false;
+	}
+
+	capacity = size;
+	return true;
+}
+
+void C3D_FrameStatsReset(void)
+{
+	count = head = 0;
+}
+
+void C3Di_FrameStatsRecord(const C3D_FrameStats* stats)
+{
+	if (!capacity)
+		return;
+
+	history[head] = *stats;
+	head = (head+1) % capacity;
+	if (count < capacity)
+		count ++;
+}
+
+size_t C3D_FrameStatsCount(void)
+{
+	return count;
+}
+
+const C3D_FrameStats* C3D_FrameStatsGet(size_t i)
+{
+	if (i >= count)
+		return NULL;
+	return &history[(head + capacity - count + i) % capacity];
+}
+
+static float C3Di_FrameStatValue(const C3D_FrameStats* stats, C3D_FrameStat stat)
+{
+	switch (stat)
+	{
+		case C3D_STAT_CPU:          return stats->cpuTime;
+		case C3D_STAT_GPU:          return stats->gpuTime;
+		case C3D_STAT_CMDWORDS:     return (float)stats->cmdWords;
+		case C3D_STAT_VBLANKMISSES: return (float)stats->vblankMisses;
+	}
+	return 0.0f;
+}
+
+static int C3Di_FloatCompare(const void* a, const void* b)
+{
+	float x = *(const float*)a, y = *(const float*)b;
+	return (x > y) - (x < y);
+}
+
+float C3D_FrameStatsPercentile(C3D_FrameStat stat, float percentile)
+{
+	size_t i;
+	if (!count)
+		return 0.0f;
+
+	for (i = 0; i < count; i ++)
+		scratch[i] = C3Di_FrameStatValue(C3D_FrameStatsGet(i), stat);
+	qsort(scratch, count, sizeof(float), C3Di_FloatCompare);
+
+	if (percentile <= 0.0f)
+		return scratch[0];
+	if (percentile >= 100.0f)
+		return scratch[count-1];
+
+	// Nearest rank: smallest value with at least percentile% of samples at or below it
+	size_t rank = (size_t)ceilf(percentile / 100.0f * count);
+	return scratch[rank ? rank-1 : 0];
+}
+
+bool C3D_FrameStatsExport(FILE* f, C3D_FrameStatsFormat format)
+{
+	static const char* names[] = { "cpu", "gpu", "cmdWords", "vblankMisses" };
+	static const float pcts[] = { 50.0f, 95.0f, 99.0f };
+	size_t i;
+	int s, p;
+
+	if (!f)
+		return false;
+
+	if (format == C3D_STATS_CSV)
+	{
+		fprintf(f, "frame,cpu_ms,gpu_ms,cmd_words,vblank_misses\n");
+		for (i = 0; i < count; i ++)
+		{
+			const C3D_FrameStats* st = C3D_FrameStatsGet(i);
+			fprintf(f, "%u,%.3f,%.3f,%lu,%lu\n", (unsigned)i, st->cpuTime, st->gpuTime,
+				(unsigned long)st->cmdWords, (unsigned long)st->vblankMisses);
+		}
+		return !ferror(f);
+	}
+
+	fprintf(f, "{\n\t\"frames\": [");
+	for (i = 0; i < count; i ++)
+	{
+		const C3D_FrameStats* st = C3D_FrameStatsGet(i);
+		fprintf(f, "%s\n\t\t{ \"cpu\": %.3f, \"gpu\": %.3f, \"cmdWords\": %lu, \"vblankMisses\": %lu }",
+			i ? "," : "", st->cpuTime, st->gpuTime, (unsigned long)st->cmdWords, (unsigned long)st->vblankMisses);
+	}
+	fprintf(f, "\n\t],\n\t\"percentiles\": {");
+	for (s = 0; s < 4; s ++)
+	{
+		fprintf(f, "%s\n\t\t\"%s\": {", s ? "," : "", names[s]);
+		for (p = 0; p < 3; p ++)
+			fprintf(f, "%s \"p%d\": %.3f", p ? "," : "", (int)pcts[p], C3D_FrameStatsPercentile((C3D_FrameStat)s, pcts[p]));
+		fprintf(f, " }");
+	}
+	fprintf(f, "\n\t}\n}\n");
+	return !ferror(f);
+}
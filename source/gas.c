@@ -175,7 +175,7 @@ void C3Di_GasUpdate(C3D_Context* ctx)
 	if (ctx->flags & C3DiF_GasLut)
 	{
 		ctx->flags &= ~C3DiF_GasLut;
-		if (ctx->gasLut)
+		if (ctx->gasLut && C3Di_LutNeedsUpload(C3Di_LutSlot_Gas, ctx->gasLut, sizeof(C3D_GasLut)))
 		{
 			GPUCMD_AddWrite(GPUREG_GAS_LUT_INDEX, 0);
 			GPUCMD_AddWrites(GPUREG_GAS_LUT_DATA, (u32*)ctx->gasLut, 16);
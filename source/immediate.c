@@ -64,4 +64,5 @@ void C3D_ImmDrawEnd(void)
 	GPUCMD_AddWrite(GPUREG_VTX_FUNC, 1);
 
 	C3Di_GetContext()->flags |= C3DiF_DrawUsed;
+	C3Di_FrameDrawDone();
 }
@@ -4,8 +4,10 @@
 #include <c3d/proctex.h>
 #include <c3d/light.h>
 #include <c3d/framebuffer.h>
+#include <c3d/renderqueue.h>
 #include <c3d/texenv.h>
 #include <c3d/fog.h>
+#include <c3d/framestats.h>
 
 #define C3D_UNUSED __attribute__((unused))
 
@@ -14,6 +16,7 @@ typedef struct
 	u32 fragOpMode;
 	u32 fragOpShadow;
 	u32 zScale, zOffset;
+	float zScaleF, zOffsetF;
 	GPU_CULLMODE cullMode;
 	bool zBuffer, earlyDepth;
 	GPU_EARLYDEPTHFUNC earlyDepthFunc;
@@ -28,6 +31,25 @@ typedef struct
 	GPU_LOGICOP clrLogicOp;
 } C3D_Effect;
 
+typedef struct
+{
+	const void* lut;
+	u32 hash;
+} C3D_LutSlot;
+
+// Hardware LUT slots tracked by the residency cache
+enum
+{
+#define C3Di_LutSlot_LightEnv(n) (n)
+#define C3Di_LutSlot_LightSP(n)  (6+(n))
+#define C3Di_LutSlot_LightDA(n)  (14+(n))
+	C3Di_LutSlot_Fog = 22,
+	C3Di_LutSlot_Gas = 23,
+#define C3Di_LutSlot_ProcTex(n)  (24+(n))
+	C3Di_LutSlot_ProcTexColor = 27,
+	C3Di_LutSlot_Count,
+};
+
 typedef struct
 {
 	gxCmdQueue_s gxQueue;
@@ -50,7 +72,7 @@ typedef struct
 
 	u32 texEnvBuf, texEnvBufClr;
 	u32 fogClr;
-	C3D_FogLut* fogLut;
+	const C3D_FogLut* fogLut;
 
 	u16 gasAttn, gasAccMax;
 	u32 gasLightXY, gasLightZ, gasLightZColor;
@@ -59,15 +81,18 @@ typedef struct
 	C3D_GasLut* gasLut;
 
 	C3D_ProcTex* procTex;
-	C3D_ProcTexLut* procTexLut[3];
+	const C3D_ProcTexLut* procTexLut[3];
 	C3D_ProcTexColorLut* procTexColorLut;
 
 	C3D_FrameBuf fb;
+	u8 depthPhase; // 0: off, otherwise 1 + depth alternation phase of the target drawn on
 	u32 viewport[5];
 	u32 scissor[3];
 
 	u16 fixedAttribDirty, fixedAttribEverDirty;
 	C3D_FVec fixedAttribs[12];
+
+	C3D_LutSlot lutSlots[C3Di_LutSlot_Count];
 } C3D_Context;
 
 enum
@@ -130,6 +155,14 @@ static inline bool addrIsVRAM(const void* addr)
 	return vaddr >= OS_VRAM_VADDR && vaddr < OS_VRAM_VADDR + OS_VRAM_SIZE;
 }
 
+static inline void allocFree(void* addr)
+{
+	if (addrIsVRAM(addr))
+		vramFree(addr);
+	else
+		linearFree(addr);
+}
+
 static inline vramAllocPos addrGetVRAMBank(const void* addr)
 {
 	u32 vaddr = (u32)addr;
@@ -140,6 +173,7 @@ void C3Di_UpdateContext(void);
 void C3Di_AttrInfoBind(C3D_AttrInfo* info);
 void C3Di_BufInfoBind(C3D_BufInfo* info);
 void C3Di_FrameBufBind(C3D_FrameBuf* fb);
+void C3Di_FrameBufBarrier(void);
 void C3Di_TexEnvBind(int id, C3D_TexEnv* env);
 void C3Di_SetTex(int unit, C3D_Tex* tex);
 void C3Di_EffectBind(C3D_Effect* effect);
@@ -147,9 +181,13 @@ void C3Di_GasUpdate(C3D_Context* ctx);
 
 void C3Di_LightMtlBlend(C3D_Light* light);
 
+bool C3Di_LutNeedsUpload(int slot, const void* lut, size_t size);
+void C3Di_LutCacheReset(void);
+
 void C3Di_DirtyUniforms(GPU_SHADER_TYPE type);
 void C3Di_LoadShaderUniforms(shaderInstance_s* si);
 void C3Di_ClearShaderUniforms(GPU_SHADER_TYPE type);
+void C3Di_ApplyUniformLatches(void);
 
 bool C3Di_SplitFrame(u32** pBuf, u32* pSize);
 
@@ -158,3 +196,52 @@ void C3Di_RenderQueueExit(void);
 void C3Di_RenderQueueWaitDone(void);
 void C3Di_RenderQueueEnableVBlank(void);
 void C3Di_RenderQueueDisableVBlank(void);
+bool C3Di_InFrame(void);
+void C3Di_FrameDrawDone(void);
+void C3Di_QueueMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* buf1a, u32 buf1v, u32* buf1e, u16 control1);
+bool C3Di_FlushTrackingEnabled(void);
+bool C3Di_FlushTracked(void);
+void C3Di_FrameBufClearRows(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 y0, u16 y1);
+
+// One buffer range of a memory fill
+typedef struct
+{
+	u32* start;
+	u32* end;
+	u32 value;
+	u16 control;
+} C3Di_FillSpan;
+
+static inline u32 C3Di_FrameBufTileSize(const C3D_FrameBuf* frameBuf)
+{
+	return frameBuf->block32 ? 32 : 8;
+}
+
+int C3Di_FrameBufClearSpans(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 y0, u16 y1, C3Di_FillSpan spans[2]);
+// Pairs consecutive spans into two-buffer memory fills
+typedef struct
+{
+	C3Di_FillSpan pending;
+	bool havePending;
+} C3Di_FillBatch;
+
+void C3Di_FillPush(C3Di_FillBatch* batch, const C3Di_FillSpan* spans, int count);
+void C3Di_FillFlush(C3Di_FillBatch* batch);
+void C3Di_QueueTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags);
+
+void C3Di_ProfileQueueRun(void);
+void C3Di_ProfileQueueCleared(void);
+void C3Di_ProfileFrameBegin(void);
+
+void C3Di_FrameStatsRecord(const C3D_FrameStats* stats);
+
+void C3Di_RenderTargetDestroy(C3D_RenderTarget* target);
+C3D_RenderTarget* C3Di_RenderTargetFromBuffers(int width, int height, void* colorBuf, GPU_COLORBUF colorFmt, void* depthBuf, GPU_DEPTHBUF depthFmt);
+
+u32 C3Di_TexInitSize(C3D_TexInitParams p);
+void C3Di_TexInitWithMem(C3D_Tex* tex, C3D_TexInitParams p, void* data);
+void C3Di_DeferredRenderTarget(C3D_RenderTarget* target);
+void C3Di_DeferredFrameEnd(void);
+void C3Di_DeferredCollect(bool all);
+
+void C3Di_RecReplay(u16 op, const void* data);
@@ -155,7 +155,7 @@ void C3D_LightSpotDir(C3D_Light* light, float x, float y, float z)
 	light->flags |= C3DF_Light_Dirty;
 }
 
-void C3D_LightSpotLut(C3D_Light* light, C3D_LightLut* lut)
+void C3D_LightSpotLut(C3D_Light* light, const C3D_LightLut* lut)
 {
 	bool hasLut = lut != NULL;
 	C3Di_EnableCommon(light, hasLut, GPU_LC1_SPOTBIT(light->id));
@@ -169,7 +169,7 @@ void C3D_LightDistAttnEnable(C3D_Light* light, bool enable)
 	C3Di_EnableCommon(light, enable, GPU_LC1_ATTNBIT(light->id));
 }
 
-void C3D_LightDistAttn(C3D_Light* light, C3D_LightLutDA* lut)
+void C3D_LightDistAttn(C3D_Light* light, const C3D_LightLutDA* lut)
 {
 	bool hasLut = lut != NULL;
 	C3Di_EnableCommon(light, hasLut, GPU_LC1_ATTNBIT(light->id));
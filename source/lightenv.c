@@ -15,9 +15,12 @@ static void C3Di_LightEnvMtlBlend(C3D_LightEnv* env)
 	env->conf.ambient = color;
 }
 
-static void C3Di_LightLutUpload(u32 config, C3D_LightLut* lut)
+static void C3Di_LightLutUpload(int slot, u32 config, const C3D_LightLut* lut)
 {
 	int i;
+	if (!C3Di_LutNeedsUpload(slot, lut, sizeof(*lut)))
+		return;
+
 	GPUCMD_AddWrite(GPUREG_LIGHTING_LUT_INDEX, config);
 	for (i = 0; i < 256; i += 8)
 		GPUCMD_AddWrites(GPUREG_LIGHTING_LUT_DATA0, &lut->data[i], 8);
@@ -93,7 +96,7 @@ void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 		{
 			static const u8 lutIds[] = { 0, 1, 3, 4, 5, 6 };
 			if (!(env->flags & C3DF_LightEnv_LutDirty(i))) continue;
-			C3Di_LightLutUpload(GPU_LIGHTLUTIDX(GPU_LUTSELECT_COMMON, (u32)lutIds[i], 0), env->luts[i]);
+			C3Di_LightLutUpload(C3Di_LutSlot_LightEnv(i), GPU_LIGHTLUTIDX(GPU_LUTSELECT_COMMON, (u32)lutIds[i], 0), env->luts[i]);
 		}
 
 		env->flags &= ~C3DF_LightEnv_LutDirtyAll;
@@ -119,13 +122,13 @@ void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 
 		if (light->flags & C3DF_Light_SPDirty)
 		{
-			C3Di_LightLutUpload(GPU_LIGHTLUTIDX(GPU_LUTSELECT_SP, i, 0), light->lut_SP);
+			C3Di_LightLutUpload(C3Di_LutSlot_LightSP(i), GPU_LIGHTLUTIDX(GPU_LUTSELECT_SP, i, 0), light->lut_SP);
 			light->flags &= ~C3DF_Light_SPDirty;
 		}
 
 		if (light->flags & C3DF_Light_DADirty)
 		{
-			C3Di_LightLutUpload(GPU_LIGHTLUTIDX(GPU_LUTSELECT_DA, i, 0), light->lut_DA);
+			C3Di_LightLutUpload(C3Di_LutSlot_LightDA(i), GPU_LIGHTLUTIDX(GPU_LUTSELECT_DA, i, 0), light->lut_DA);
 			light->flags &= ~C3DF_Light_DADirty;
 		}
 	}
@@ -196,7 +199,7 @@ void C3D_LightEnvAmbient(C3D_LightEnv* env, float r, float g, float b)
 	env->flags |= C3DF_LightEnv_MtlDirty;
 }
 
-void C3D_LightEnvLut(C3D_LightEnv* env, GPU_LIGHTLUTID lutId, GPU_LIGHTLUTINPUT input, bool negative, C3D_LightLut* lut)
+void C3D_LightEnvLut(C3D_LightEnv* env, GPU_LIGHTLUTID lutId, GPU_LIGHTLUTINPUT input, bool negative, const C3D_LightLut* lut)
 {
 	static const s8 ids[] = { 0, 1, -1, 2, 3, 4, 5, -1 };
 	int id = ids[lutId];
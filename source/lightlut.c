@@ -1,33 +1,35 @@
-#include "internal.h"
+#include <string.h>
+#include <c3d/lightlut.h>
 
-void LightLut_FromArray(C3D_LightLut* lut, float* data)
+static inline u32 C3Di_LightLutEntry(float in, float diff)
 {
-	int i;
-	for (i = 0; i < 256; i ++)
+	u32 val = 0;
+	if (in > 0.0f)
 	{
-		float in = data[i], diff = data[i+256];
+		in *= 0x1000;
+		val = (in < 0x1000) ? (u32)in : 0xFFF;
+	}
 
-		u32 val = 0;
-		if (in > 0.0f)
+	u32 val2 = 0;
+	if (diff != 0.0f)
+	{
+		if (diff < 0)
 		{
-			in *= 0x1000;
-			val = (in < 0x1000) ? (u32)in : 0xFFF;
+			diff = -diff;
+			val2 = 0x800;
 		}
+		diff *= 0x800;
+		val2 |= (diff < 0x800) ? (u32)diff : 0x7FF;
+	}
 
-		u32 val2 = 0;
-		if (diff != 0.0f)
-		{
-			if (diff < 0)
-			{
-				diff = -diff;
-				val2 = 0x800;
-			}
-			diff *= 0x800;
-			val2 |= (diff < 0x800) ? (u32)diff : 0x7FF;
-		}
+	return val | (val2 << 12);
+}
 
-		lut->data[i] = val | (val2 << 12);
-	}
+void LightLut_FromArray(C3D_LightLut* lut, float* data)
+{
+	int i;
+	for (i = 0; i < 256; i ++)
+		lut->data[i] = C3Di_LightLutEntry(data[i], data[i+256]);
 }
 
 void LightLut_FromFunc(C3D_LightLut* lut, C3D_LightLutFunc func, float param, bool negative)
@@ -45,7 +47,11 @@ void LightLut_FromFunc(C3D_LightLut* lut, C3D_LightLutFunc func, float param, bo
 		if (i < max)
 			data[idx] = val;
 		if (i > min)
-			data[idx+255] = val-data[idx-1];
+		{
+			// Entry preceding this one, wrapping around in two's complement mode
+			int prev = negative ? ((i-1) & 0xFF) : (i-1);
+			data[prev+256] = val-data[prev];
+		}
 	}
 	LightLut_FromArray(lut, data);
 }
@@ -71,3 +77,92 @@ void LightLutDA_Create(C3D_LightLutDA* lut, C3D_LightLutFuncDA func, float from,
 
 	LightLut_FromArray(&lut->lut, data);
 }
+
+// Samples and quantizes in one pass; each sample is evaluated once and reused
+// as the next entry's base. Instantiated per shape so the switch folds away.
+static inline __attribute__((always_inline)) void C3Di_LightLutShape(u32* out, C3D_LutShape shape, float a, float b, bool negative, int first, int last)
+{
+	int i, max = negative ? 128 : 256;
+	float val = 0.0f;
+	for (i = first; i < last; i ++)
+	{
+		int pos = (negative && i >= 128) ? (i-256) : i;
+		if (i == first || pos == -128)
+			val = C3D_LutShapeEval(shape, (float)pos/max, a, b);
+		float next = C3D_LutShapeEval(shape, (float)(pos+1)/max, a, b);
+		out[i] = C3Di_LightLutEntry(val, next-val);
+		val = next;
+	}
+}
+
+static inline __attribute__((always_inline)) void C3Di_LightLutDAShape(u32* out, C3D_LutShape shape, float from, float range, float a, float b, int first, int last)
+{
+	int i;
+	float val = C3D_LutShapeEval(shape, from + range*first/256.0f, a, b);
+	for (i = first; i < last; i ++)
+	{
+		float next = C3D_LutShapeEval(shape, from + range*(i+1)/256.0f, a, b);
+		out[i] = C3Di_LightLutEntry(val, next-val);
+		val = next;
+	}
+}
+
+void LightLut_FromShapeRange(C3D_LightLut* lut, C3D_LutShape shape, float a, float b, bool negative, int first, int count)
+{
+	int last = first+count;
+	if (first < 0) first = 0;
+	if (last > 256) last = 256;
+	if (first >= last)
+		return;
+
+	switch (shape)
+	{
+		case C3D_LUT_POW:
+			C3Di_LightLutShape(lut->data, C3D_LUT_POW, a, b, negative, first, last);
+			break;
+		case C3D_LUT_EXP:
+			C3Di_LightLutShape(lut->data, C3D_LUT_EXP, a, b, negative, first, last);
+			break;
+		case C3D_LUT_LINEAR:
+			C3Di_LightLutShape(lut->data, C3D_LUT_LINEAR, a, b, negative, first, last);
+			break;
+		case C3D_LUT_SMOOTHSTEP:
+			C3Di_LightLutShape(lut->data, C3D_LUT_SMOOTHSTEP, a, b, negative, first, last);
+			break;
+		case C3D_LUT_QUADRATIC:
+			C3Di_LightLutShape(lut->data, C3D_LUT_QUADRATIC, a, b, negative, first, last);
+			break;
+	}
+}
+
+void LightLutDA_FromShapeRange(C3D_LightLutDA* lut, C3D_LutShape shape, float from, float to, float a, float b, int first, int count)
+{
+	float range = to-from;
+	lut->scale = 1.0f / range;
+	lut->bias = -from*lut->scale;
+
+	int last = first+count;
+	if (first < 0) first = 0;
+	if (last > 256) last = 256;
+	if (first >= last)
+		return;
+
+	switch (shape)
+	{
+		case C3D_LUT_POW:
+			C3Di_LightLutDAShape(lut->lut.data, C3D_LUT_POW, from, range, a, b, first, last);
+			break;
+		case C3D_LUT_EXP:
+			C3Di_LightLutDAShape(lut->lut.data, C3D_LUT_EXP, from, range, a, b, first, last);
+			break;
+		case C3D_LUT_LINEAR:
+			C3Di_LightLutDAShape(lut->lut.data, C3D_LUT_LINEAR, from, range, a, b, first, last);
+			break;
+		case C3D_LUT_SMOOTHSTEP:
+			C3Di_LightLutDAShape(lut->lut.data, C3D_LUT_SMOOTHSTEP, from, range, a, b, first, last);
+			break;
+		case C3D_LUT_QUADRATIC:
+			C3Di_LightLutDAShape(lut->lut.data, C3D_LUT_QUADRATIC, from, range, a, b, first, last);
+			break;
+	}
+}
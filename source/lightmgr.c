@@ -0,0 +1,351 @@
+#include "internal.h"
+#include <stdlib.h>
+#include <c3d/lightmgr.h>
+
+#define C3Di_LightMgr_Black (-2)
+
+static inline int C3Di_LightMgrCell(C3D_LightMgr* mgr, float x)
+{
+	return (int)floorf(x / mgr->cellSize);
+}
+
+static inline u16 C3Di_LightMgrHash(int x, int y, int z)
+{
+	return ((u32)x*73856093U ^ (u32)y*19349663U ^ (u32)z*83492791U) & (C3D_LIGHTMGR_BUCKETS-1);
+}
+
+static u16 C3Di_LightMgrBucket(C3D_LightMgr* mgr, C3D_FVec pos)
+{
+	return C3Di_LightMgrHash(C3Di_LightMgrCell(mgr, pos.x), C3Di_LightMgrCell(mgr, pos.y), C3Di_LightMgrCell(mgr, pos.z));
+}
+
+static void C3Di_LightMgrLink(C3D_LightMgr* mgr, int handle)
+{
+	C3D_ManagedLight* ml = &mgr->lights[handle];
+	ml->bucket = C3Di_LightMgrBucket(mgr, ml->position);
+	ml->next = mgr->buckets[ml->bucket];
+	mgr->buckets[ml->bucket] = handle;
+}
+
+static void C3Di_LightMgrUnlink(C3D_LightMgr* mgr, int handle)
+{
+	s32* link = &mgr->buckets[mgr->lights[handle].bucket];
+	while (*link != handle)
+		link = &mgr->lights[*link].next;
+	*link = mgr->lights[handle].next;
+}
+
+static inline C3D_ManagedLight* C3Di_LightMgrGet(C3D_LightMgr* mgr, int handle)
+{
+	if (handle < 0 || handle >= mgr->numLights)
+		return NULL;
+	C3D_ManagedLight* ml = &mgr->lights[handle];
+	return (ml->flags & C3DF_ManagedLight_Used) ? ml : NULL;
+}
+
+bool C3D_LightMgrInit(C3D_LightMgr* mgr, C3D_LightEnv* env, float cellSize)
+{
+	int i;
+	memset(mgr, 0, sizeof(*mgr));
+	mgr->env = env;
+	mgr->cellSize = cellSize > 0.0f ? cellSize : 1.0f;
+	mgr->freeList = -1;
+	Mtx_Identity(&mgr->view);
+
+	for (i = 0; i < C3D_LIGHTMGR_BUCKETS; i ++)
+		mgr->buckets[i] = -1;
+
+	for (i = 0; i < 8; i ++)
+	{
+		C3D_Light* light = &mgr->hw[mgr->numSlots];
+		if (C3D_LightInit(light, env) < 0)
+			break;
+		C3D_LightEnable(light, false);
+		mgr->slotLight[mgr->numSlots++] = -1;
+	}
+
+	return mgr->numSlots > 0;
+}
+
+void C3D_LightMgrFini(C3D_LightMgr* mgr)
+{
+	int i;
+	for (i = 0; i < mgr->numSlots; i ++)
+	{
+		C3D_Light* light = &mgr->hw[i];
+		mgr->env->lights[light->id] = NULL;
+	}
+	mgr->env->flags |= C3DF_LightEnv_LCDirty;
+
+	free(mgr->lights);
+	mgr->lights = NULL;
+	mgr->numLights = mgr->capacity = mgr->numSlots = 0;
+}
+
+void C3D_LightMgrViewMatrix(C3D_LightMgr* mgr, const C3D_Mtx* view)
+{
+	if (memcmp(&mgr->view, view, sizeof(*view)) == 0)
+		return;
+
+	Mtx_Copy(&mgr->view, view);
+	mgr->viewVersion ++;
+}
+
+int C3D_LightMgrAdd(C3D_LightMgr* mgr, C3D_FVec position, float radius)
+{
+	int handle = mgr->freeList;
+	if (handle >= 0)
+		mgr->freeList = mgr->lights[handle].next;
+	else
+	{
+		if (mgr->numLights == mgr->capacity)
+		{
+			int capacity = mgr->capacity ? mgr->capacity*2 : 32;
+			C3D_ManagedLight* lights = (C3D_ManagedLight*)realloc(mgr->lights, capacity*sizeof(C3D_ManagedLight));
+			if (!lights)
+				return -1;
+			mgr->lights = lights;
+			mgr->capacity = capacity;
+		}
+		handle = mgr->numLights++;
+	}
+
+	C3D_ManagedLight* ml = &mgr->lights[handle];
+	u32 version = ml->version;
+	memset(ml, 0, sizeof(*ml));
+	ml->position = position;
+	ml->radius = radius;
+	ml->color[0] = ml->color[1] = ml->color[2] = 1.0f;
+	ml->flags = C3DF_ManagedLight_Used;
+	ml->version = version+1;
+
+	if (radius > mgr->maxRadius)
+		mgr->maxRadius = radius;
+
+	C3Di_LightMgrLink(mgr, handle);
+	return handle;
+}
+
+void C3D_LightMgrRemove(C3D_LightMgr* mgr, int handle)
+{
+	int i;
+	C3D_ManagedLight* ml = C3Di_LightMgrGet(mgr, handle);
+	if (!ml) return;
+
+	C3Di_LightMgrUnlink(mgr, handle);
+	ml->flags = 0;
+	ml->version ++;
+	ml->next = mgr->freeList;
+	mgr->freeList = handle;
+
+	// A removed light must not stay lit until the next selection
+	for (i = 0; i < mgr->numSlots; i ++)
+		if (mgr->slotLight[i] == handle)
+		{
+			mgr->slotLight[i] = -1;
+			C3D_LightEnable(&mgr->hw[i], false);
+		}
+}
+
+void C3D_LightMgrMove(C3D_LightMgr* mgr, int handle, C3D_FVec position)
+{
+	C3D_ManagedLight* ml = C3Di_LightMgrGet(mgr, handle);
+	if (!ml) return;
+
+	ml->position = position;
+	ml->version ++;
+	if (C3Di_LightMgrBucket(mgr, position) != ml->bucket)
+	{
+		C3Di_LightMgrUnlink(mgr, handle);
+		C3Di_LightMgrLink(mgr, handle);
+	}
+}
+
+void C3D_LightMgrColor(C3D_LightMgr* mgr, int handle, float r, float g, float b)
+{
+	C3D_ManagedLight* ml = C3Di_LightMgrGet(mgr, handle);
+	if (!ml) return;
+
+	ml->color[0] = r;
+	ml->color[1] = g;
+	ml->color[2] = b;
+	ml->version ++;
+}
+
+void C3D_LightMgrDistAttn(C3D_LightMgr* mgr, int handle, const C3D_LightLutDA* lut)
+{
+	C3D_ManagedLight* ml = C3Di_LightMgrGet(mgr, handle);
+	if (!ml) return;
+
+	ml->lut_DA = lut;
+	ml->version ++;
+}
+
+typedef struct
+{
+	int count, max;
+	s32 handle[8];
+	float score[8];
+} C3Di_LightPick;
+
+static void C3Di_LightMgrConsider(C3D_LightMgr* mgr, C3Di_LightPick* pick, int handle, C3D_FVec center, float radius)
+{
+	C3D_ManagedLight* ml = &mgr->lights[handle];
+	float dist = FVec3_Distance(ml->position, center);
+	if (dist >= ml->radius + radius)
+		return;
+
+	// Falloff measured from the sphere surface, weighted by brightness
+	float t = dist > radius ? (dist-radius)/ml->radius : 0.0f;
+	float lum = ml->color[0] > ml->color[1] ? ml->color[0] : ml->color[1];
+	if (ml->color[2] > lum) lum = ml->color[2];
+	float score = lum*(1.0f-t)*(1.0f-t);
+
+	if (pick->count == pick->max && score <= pick->score[pick->count-1])
+		return;
+
+	int i = pick->count < pick->max ? pick->count++ : pick->count-1;
+	for (; i > 0 && pick->score[i-1] < score; i --)
+	{
+		pick->score[i] = pick->score[i-1];
+		pick->handle[i] = pick->handle[i-1];
+	}
+	pick->score[i] = score;
+	pick->handle[i] = handle;
+}
+
+static void C3Di_LightMgrGather(C3D_LightMgr* mgr, C3Di_LightPick* pick, C3D_FVec center, float radius)
+{
+	int x, y, z, i;
+	float reach = radius + mgr->maxRadius;
+	int x0 = C3Di_LightMgrCell(mgr, center.x-reach), x1 = C3Di_LightMgrCell(mgr, center.x+reach);
+	int y0 = C3Di_LightMgrCell(mgr, center.y-reach), y1 = C3Di_LightMgrCell(mgr, center.y+reach);
+	int z0 = C3Di_LightMgrCell(mgr, center.z-reach), z1 = C3Di_LightMgrCell(mgr, center.z+reach);
+	float cells = (float)(x1-x0+1)*(y1-y0+1)*(z1-z0+1);
+
+	// Several cells may hash to the same bucket, visit each bucket only once
+	mgr->stamp ++;
+	if (cells >= C3D_LIGHTMGR_BUCKETS)
+	{
+		for (i = 0; i < C3D_LIGHTMGR_BUCKETS; i ++)
+		{
+			s32 h;
+			for (h = mgr->buckets[i]; h >= 0; h = mgr->lights[h].next)
+				C3Di_LightMgrConsider(mgr, pick, h, center, radius);
+		}
+		return;
+	}
+
+	for (z = z0; z <= z1; z ++)
+		for (y = y0; y <= y1; y ++)
+			for (x = x0; x <= x1; x ++)
+			{
+				s32 h;
+				u16 b = C3Di_LightMgrHash(x, y, z);
+				if (mgr->bucketStamp[b] == mgr->stamp)
+					continue;
+				mgr->bucketStamp[b] = mgr->stamp;
+				for (h = mgr->buckets[b]; h >= 0; h = mgr->lights[h].next)
+					C3Di_LightMgrConsider(mgr, pick, h, center, radius);
+			}
+}
+
+static void C3Di_LightMgrWriteSlot(C3D_LightMgr* mgr, int slot, int handle)
+{
+	C3D_Light* light = &mgr->hw[slot];
+	C3D_ManagedLight* ml = &mgr->lights[handle];
+
+	if (mgr->slotLight[slot] != handle || mgr->slotVersion[slot] != ml->version)
+	{
+		C3D_LightColor(light, ml->color[0], ml->color[1], ml->color[2]);
+		if (ml->lut_DA)
+			C3D_LightDistAttn(light, ml->lut_DA);
+		else
+		{
+			C3D_LightDistAttnEnable(light, false);
+			light->lut_DA = NULL;
+		}
+	}
+
+	if (mgr->slotLight[slot] != handle || mgr->slotVersion[slot] != ml->version || mgr->slotView[slot] != mgr->viewVersion)
+	{
+		C3D_FVec pos = ml->position;
+		pos.w = 1.0f;
+		pos = Mtx_MultiplyFVec4(&mgr->view, pos);
+		pos.w = 1.0f;
+		C3D_LightPosition(light, &pos);
+	}
+
+	mgr->slotLight[slot] = handle;
+	mgr->slotVersion[slot] = ml->version;
+	mgr->slotView[slot] = mgr->viewVersion;
+	C3D_LightEnable(light, true);
+}
+
+// Whether the environment has enabled lights of its own
+static bool C3Di_LightMgrEnvLit(C3D_LightMgr* mgr)
+{
+	int i;
+	for (i = 0; i < 8; i ++)
+	{
+		C3D_Light* light = mgr->env->lights[i];
+		if (light && (light->flags & C3DF_Light_Enabled) && (light < mgr->hw || light >= mgr->hw+8))
+			return true;
+	}
+	return false;
+}
+
+int C3D_LightMgrSelect(C3D_LightMgr* mgr, C3D_FVec center, float radius)
+{
+	int i, j;
+	C3Di_LightPick pick;
+	pick.count = 0;
+	pick.max = mgr->numSlots;
+	if (!pick.max || !mgr->numLights)
+		pick.max = 0;
+	else
+		C3Di_LightMgrGather(mgr, &pick, center, radius);
+
+	// Keep lights that are still selected in the slot they already occupy
+	bool placed[8] = { false };
+	bool taken[8] = { false };
+	for (i = 0; i < mgr->numSlots; i ++)
+	{
+		for (j = 0; j < pick.count; j ++)
+			if (!placed[j] && pick.handle[j] == mgr->slotLight[i])
+				break;
+		if (j == pick.count)
+			continue;
+		C3Di_LightMgrWriteSlot(mgr, i, pick.handle[j]);
+		placed[j] = taken[i] = true;
+	}
+
+	for (i = 0, j = 0; j < pick.count; j ++)
+	{
+		if (placed[j]) continue;
+		while (taken[i]) i ++;
+		C3Di_LightMgrWriteSlot(mgr, i, pick.handle[j]);
+		taken[i] = true;
+	}
+
+	// Slot 0 is left alone when it is about to hold the black light, so the
+	// light count isn't toggled (and re-emitted) on every unlit draw
+	bool black = !pick.count && mgr->numSlots && !C3Di_LightMgrEnvLit(mgr);
+	for (i = black ? 1 : 0; i < mgr->numSlots; i ++)
+		if (!taken[i])
+			C3D_LightEnable(&mgr->hw[i], false);
+
+	if (black)
+	{
+		// The hardware always evaluates at least one light, make it a black one
+		C3D_Light* light = &mgr->hw[0];
+		if (mgr->slotLight[0] != C3Di_LightMgr_Black)
+		{
+			C3D_LightColor(light, 0.0f, 0.0f, 0.0f);
+			mgr->slotLight[0] = C3Di_LightMgr_Black;
+		}
+		C3D_LightEnable(light, true);
+	}
+
+	return pick.count;
+}
@@ -0,0 +1,31 @@
+#include "internal.h"
+
+static u32 C3Di_LutHash(const u32* data, size_t words)
+{
+	// FNV-1a over whole words; LUT contents are already well mixed
+	u32 hash = 0x811C9DC5;
+	size_t i;
+	for (i = 0; i < words; i ++)
+		hash = (hash ^ data[i]) * 0x01000193;
+	return hash;
+}
+
+bool C3Di_LutNeedsUpload(int slot, const void* lut, size_t size)
+{
+	C3D_LutSlot* s = &C3Di_GetContext()->lutSlots[slot];
+	u32 hash = C3Di_LutHash((const u32*)lut, size/4);
+
+	// The hardware slot already holds this exact table
+	if (s->lut == lut && s->hash == hash)
+		return false;
+
+	s->lut = lut;
+	s->hash = hash;
+	return true;
+}
+
+void C3Di_LutCacheReset(void)
+{
+	C3D_Context* ctx = C3Di_GetContext();
+	memset(ctx->lutSlots, 0, sizeof(ctx->lutSlots));
+}
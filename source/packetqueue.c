@@ -0,0 +1,91 @@
+#include <c3d/packetqueue.h>
+#include <stddef.h>
+
+// Kept free of libctru so the ring can be tested on the host
+
+bool C3D_PacketQueueInit(C3D_PacketQueue* q, void* buf, u32 size)
+{
+	if (size < 16 || (size & (size-1)) || ((unsigned long)buf & 3))
+		return false;
+
+	q->buf = (u8*)buf;
+	q->size = size;
+	q->head = 0;
+	q->tail = 0;
+	q->reserve = 0;
+	return true;
+}
+
+void* C3D_PacketBegin(C3D_PacketQueue* q, u16 op, u32 size)
+{
+	u32 need = C3D_PACKET_SIZE(size);
+	if (op == C3D_PACKET_WRAP || size > 0xFFFF || need > q->size/4)
+		return NULL;
+
+	u32 head = q->head;
+	u32 tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+	u32 off = head & (q->size-1);
+	u32 contig = q->size - off;
+	u32 total = need > contig ? contig+need : need;
+
+	if (q->size - (head-tail) < total)
+		return NULL;
+
+	if (need > contig)
+	{
+		// Pad to the end of the ring; published together with the packet
+		C3D_PacketHeader* pad = (C3D_PacketHeader*)&q->buf[off];
+		pad->op = C3D_PACKET_WRAP;
+		pad->size = 0;
+		head += contig;
+		off = 0;
+	}
+
+	C3D_PacketHeader* hdr = (C3D_PacketHeader*)&q->buf[off];
+	hdr->op = op;
+	hdr->size = size;
+	q->reserve = head + need;
+	return hdr+1;
+}
+
+void C3D_PacketCommit(C3D_PacketQueue* q)
+{
+	__atomic_store_n(&q->head, q->reserve, __ATOMIC_RELEASE);
+}
+
+const void* C3D_PacketPeek(C3D_PacketQueue* q, u16* op, u32* size)
+{
+	u32 tail = q->tail;
+	u32 head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+
+	while (tail != head)
+	{
+		u32 off = tail & (q->size-1);
+		const C3D_PacketHeader* hdr = (const C3D_PacketHeader*)&q->buf[off];
+		if (hdr->op == C3D_PACKET_WRAP)
+		{
+			tail += q->size - off;
+			__atomic_store_n(&q->tail, tail, __ATOMIC_RELEASE);
+			continue;
+		}
+
+		if (op)
+			*op = hdr->op;
+		if (size)
+			*size = hdr->size;
+		return hdr+1;
+	}
+	return NULL;
+}
+
+void C3D_PacketPop(C3D_PacketQueue* q)
+{
+	u32 tail = q->tail;
+	const C3D_PacketHeader* hdr = (const C3D_PacketHeader*)&q->buf[tail & (q->size-1)];
+	__atomic_store_n(&q->tail, tail + C3D_PACKET_SIZE(hdr->size), __ATOMIC_RELEASE);
+}
+
+bool C3D_PacketQueueEmpty(C3D_PacketQueue* q)
+{
+	return __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) == __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+}
@@ -65,7 +65,7 @@ static inline int lutid2idx(GPU_PROCTEX_LUTID id)
 	}
 }
 
-void C3D_ProcTexLutBind(GPU_PROCTEX_LUTID id, C3D_ProcTexLut* lut)
+void C3D_ProcTexLutBind(GPU_PROCTEX_LUTID id, const C3D_ProcTexLut* lut)
 {
 	C3D_Context* ctx = C3Di_GetContext();
 
@@ -160,6 +160,8 @@ void C3Di_ProcTexUpdate(C3D_Context* ctx)
 			int j = i ? (i+1) : 0;
 			if (!(ctx->flags & C3DiF_ProcTexLut(i)) || !ctx->procTexLut[i])
 				continue;
+			if (!C3Di_LutNeedsUpload(C3Di_LutSlot_ProcTex(i), ctx->procTexLut[i], sizeof(C3D_ProcTexLut)))
+				continue;
 
 			GPUCMD_AddWrite(GPUREG_PROCTEX_LUT, j<<8);
 			GPUCMD_AddWrites(GPUREG_PROCTEX_LUT_DATA0, *ctx->procTexLut[i], 128);
@@ -169,7 +171,7 @@ void C3Di_ProcTexUpdate(C3D_Context* ctx)
 	if (ctx->flags & C3DiF_ProcTexColorLut)
 	{
 		ctx->flags &= ~C3DiF_ProcTexColorLut;
-		if (ctx->procTexColorLut)
+		if (ctx->procTexColorLut && C3Di_LutNeedsUpload(C3Di_LutSlot_ProcTexColor, ctx->procTexColorLut, sizeof(C3D_ProcTexColorLut)))
 		{
 			GPUCMD_AddWrite(GPUREG_PROCTEX_LUT, GPU_LUT_COLOR<<8);
 			GPUCMD_AddWrites(GPUREG_PROCTEX_LUT_DATA0, ctx->procTexColorLut->color, 256);
@@ -0,0 +1,210 @@
+#include "internal.h"
+#include <c3d/renderqueue.h>
+#include <c3d/profile.h>
+
+#define C3Di_PROFILE_MAX_TICKS  128
+#define C3Di_PROFILE_MAX_FRAME  32
+#define C3Di_PROFILE_MAX_DEPTH  8
+
+static bool profileEnabled;
+
+// ticks[n] is the time at which n queue entries had completed, ticks[0] the queue start
+static u64 ticks[C3Di_PROFILE_MAX_TICKS+1];
+static volatile u16 tickCount;
+static bool tickStarted;
+
+static C3D_ProfileScope scopes[C3D_PROFILE_MAX_SCOPES];
+static int numScopes;
+
+static struct
+{
+	s8 scope;
+	u16 begin, end;
+} frameScopes[C3Di_PROFILE_MAX_FRAME];
+static int numFrameScopes;
+static s8 openStack[C3Di_PROFILE_MAX_DEPTH];
+static int openDepth;
+
+static void C3Di_ProfileIrq(C3D_UNUSED void* unused)
+{
+	u16 done = C3Di_GetContext()->gxQueue.lastEntry;
+	if (done > C3Di_PROFILE_MAX_TICKS)
+		done = C3Di_PROFILE_MAX_TICKS;
+
+	u64 now = svcGetSystemTick();
+	while (tickCount < done)
+		ticks[++tickCount] = now;
+}
+
+void C3D_ProfileEnable(bool enable)
+{
+	static const GSPGPU_Event events[] =
+	{
+		GSPGPU_EVENT_PSC0, GSPGPU_EVENT_PSC1, GSPGPU_EVENT_PPF, GSPGPU_EVENT_P3D, GSPGPU_EVENT_DMA,
+	};
+	unsigned i;
+
+	if (profileEnabled == enable)
+		return;
+
+	profileEnabled = enable;
+	numFrameScopes = 0;
+	openDepth = 0;
+	for (i = 0; i < sizeof(events)/sizeof(events[0]); i ++)
+		gspSetEventCallback(events[i], enable ? C3Di_ProfileIrq : NULL, NULL, false);
+}
+
+static int C3Di_ProfileScopeId(const char* name)
+{
+	int i;
+	for (i = 0; i < numScopes; i ++)
+		if (scopes[i].name == name || strcmp(scopes[i].name, name) == 0)
+			return i;
+
+	if (numScopes == C3D_PROFILE_MAX_SCOPES)
+		return -1;
+
+	C3D_ProfileScope* scope = &scopes[numScopes];
+	memset(scope, 0, sizeof(*scope));
+	scope->name = name;
+	return numScopes++;
+}
+
+void C3D_ProfileBegin(const char* name)
+{
+	if (openDepth == C3Di_PROFILE_MAX_DEPTH)
+		return;
+
+	// Keep Begin/End balanced even for scopes that cannot be recorded
+	s8 slot = -1;
+	int id = (profileEnabled && C3Di_InFrame()) ? C3Di_ProfileScopeId(name) : -1;
+	if (id >= 0 && numFrameScopes < C3Di_PROFILE_MAX_FRAME)
+	{
+		C3D_FrameSplit(0);
+		slot = numFrameScopes++;
+		frameScopes[slot].scope = id;
+		frameScopes[slot].begin = C3Di_GetContext()->gxQueue.numEntries;
+		frameScopes[slot].end   = 0xFFFF;
+	}
+	openStack[openDepth++] = slot;
+}
+
+void C3D_ProfileEnd(void)
+{
+	if (!openDepth)
+		return;
+
+	s8 slot = openStack[--openDepth];
+	if (slot < 0 || !C3Di_InFrame())
+		return;
+
+	C3D_FrameSplit(0);
+	frameScopes[slot].end = C3Di_GetContext()->gxQueue.numEntries;
+}
+
+void C3Di_ProfileQueueRun(void)
+{
+	if (!profileEnabled || tickStarted)
+		return;
+	ticks[0] = svcGetSystemTick();
+	tickStarted = true;
+}
+
+void C3Di_ProfileQueueCleared(void)
+{
+	int i;
+
+	// Entry indices recorded so far in this frame refer to the cleared queue
+	numFrameScopes = 0;
+	for (i = 0; i < openDepth; i ++)
+		openStack[i] = -1;
+	tickCount = 0;
+	tickStarted = false;
+}
+
+void C3Di_ProfileFrameBegin(void)
+{
+	int i;
+	float frameTime[C3D_PROFILE_MAX_SCOPES];
+	u32 frameSplits[C3D_PROFILE_MAX_SCOPES];
+	bool seen[C3D_PROFILE_MAX_SCOPES];
+
+	if (!profileEnabled)
+		return;
+
+	memset(frameTime, 0, sizeof(frameTime));
+	memset(frameSplits, 0, sizeof(frameSplits));
+	memset(seen, 0, sizeof(seen));
+
+	// The previous frame has fully completed by now
+	for (i = 0; i < numFrameScopes; i ++)
+	{
+		u16 begin = frameScopes[i].begin, end = frameScopes[i].end;
+		if (!tickStarted || end == 0xFFFF || end > tickCount || begin > end)
+			continue;
+
+		int id = frameScopes[i].scope;
+		frameTime[id] += (float)((ticks[end] - ticks[begin]) / CPU_TICKS_PER_MSEC);
+		frameSplits[id] += end - begin;
+		seen[id] = true;
+	}
+
+	for (i = 0; i < numScopes; i ++)
+	{
+		C3D_ProfileScope* scope = &scopes[i];
+		if (!seen[i])
+		{
+			scope->gpuTime = 0.0f;
+			scope->splits = 0;
+			continue;
+		}
+
+		scope->gpuTime = frameTime[i];
+		scope->splits = frameSplits[i];
+		scope->history[scope->frames++ % C3D_PROFILE_HISTORY] = frameTime[i];
+
+		int j, count = scope->frames < C3D_PROFILE_HISTORY ? scope->frames : C3D_PROFILE_HISTORY;
+		float sum = 0.0f, max = 0.0f;
+		for (j = 0; j < count; j ++)
+		{
+			sum += scope->history[j];
+			if (scope->history[j] > max)
+				max = scope->history[j];
+		}
+		scope->gpuAverage = sum / count;
+		scope->gpuMax = max;
+	}
+
+	numFrameScopes = 0;
+	openDepth = 0;
+	tickCount = 0;
+	tickStarted = false;
+}
+
+int C3D_ProfileCount(void)
+{
+	return numScopes;
+}
+
+const C3D_ProfileScope* C3D_ProfileGet(int id)
+{
+	if (id < 0 || id >= numScopes)
+		return NULL;
+	return &scopes[id];
+}
+
+const C3D_ProfileScope* C3D_ProfileFind(const char* name)
+{
+	int i;
+	for (i = 0; i < numScopes; i ++)
+		if (strcmp(scopes[i].name, name) == 0)
+			return &scopes[i];
+	return NULL;
+}
+
+void C3D_ProfileReset(void)
+{
+	numScopes = 0;
+	numFrameScopes = 0;
+	openDepth = 0;
+}
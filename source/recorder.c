@@ -0,0 +1,316 @@
+#include "internal.h"
+#include <c3d/recorder.h>
+#include <c3d/packetqueue.h>
+#include <stdlib.h>
+
+enum
+{
+	C3Di_Rec_FrameBegin,
+	C3Di_Rec_FrameDrawOn,
+	C3Di_Rec_FrameEnd,
+	C3Di_Rec_TargetClear,
+	C3Di_Rec_BindProgram,
+	C3Di_Rec_AttrInfo,
+	C3Di_Rec_BufInfo,
+	C3Di_Rec_TexEnv,
+	C3Di_Rec_TexBind,
+	C3Di_Rec_FVUnif,
+	C3Di_Rec_DrawArrays,
+	C3Di_Rec_DrawElements,
+	C3Di_Rec_Call,
+	C3Di_Rec_CmdList,
+};
+
+typedef struct
+{
+	C3D_RenderTarget* target;
+	u32 clearBits, clearColor, clearDepth;
+} C3Di_RecClear;
+
+typedef struct
+{
+	int id;
+	C3D_TexEnv env;
+} C3Di_RecTexEnv;
+
+typedef struct
+{
+	int unitId;
+	C3D_Tex* tex;
+} C3Di_RecTexBind;
+
+typedef struct
+{
+	u8 type, id, num;
+	C3D_FVec vec[];
+} C3Di_RecFVUnif;
+
+typedef struct
+{
+	GPU_Primitive_t primitive;
+	int first, count, type;
+	const void* indices;
+} C3Di_RecDraw;
+
+typedef struct
+{
+	C3D_RecFunc func;
+	u8 data[];
+} C3Di_RecCall;
+
+void C3Di_RecReplay(u16 op, const void* data)
+{
+	switch (op)
+	{
+		case C3Di_Rec_FrameBegin:
+			C3D_FrameBegin(*(const u8*)data);
+			break;
+		case C3Di_Rec_FrameDrawOn:
+			C3D_FrameDrawOn(*(C3D_RenderTarget* const*)data);
+			break;
+		case C3Di_Rec_FrameEnd:
+			C3D_FrameEnd(*(const u8*)data);
+			break;
+		case C3Di_Rec_TargetClear:
+		{
+			const C3Di_RecClear* p = (const C3Di_RecClear*)data;
+			C3D_RenderTargetClear(p->target, (C3D_ClearBits)p->clearBits, p->clearColor, p->clearDepth);
+			break;
+		}
+		case C3Di_Rec_BindProgram:
+			C3D_BindProgram(*(shaderProgram_s* const*)data);
+			break;
+		case C3Di_Rec_AttrInfo:
+			C3D_SetAttrInfo((C3D_AttrInfo*)data);
+			break;
+		case C3Di_Rec_BufInfo:
+			C3D_SetBufInfo((C3D_BufInfo*)data);
+			break;
+		case C3Di_Rec_TexEnv:
+		{
+			C3Di_RecTexEnv* p = (C3Di_RecTexEnv*)data;
+			C3D_SetTexEnv(p->id, &p->env);
+			break;
+		}
+		case C3Di_Rec_TexBind:
+		{
+			const C3Di_RecTexBind* p = (const C3Di_RecTexBind*)data;
+			C3D_TexBind(p->unitId, p->tex);
+			break;
+		}
+		case C3Di_Rec_FVUnif:
+		{
+			const C3Di_RecFVUnif* p = (const C3Di_RecFVUnif*)data;
+			memcpy(C3D_FVUnifWritePtr((GPU_SHADER_TYPE)p->type, p->id, p->num), p->vec, p->num*sizeof(C3D_FVec));
+			break;
+		}
+		case C3Di_Rec_DrawArrays:
+		{
+			const C3Di_RecDraw* p = (const C3Di_RecDraw*)data;
+			C3D_DrawArrays(p->primitive, p->first, p->count);
+			break;
+		}
+		case C3Di_Rec_DrawElements:
+		{
+			const C3Di_RecDraw* p = (const C3Di_RecDraw*)data;
+			C3D_DrawElements(p->primitive, p->count, p->type, p->indices);
+			break;
+		}
+		case C3Di_Rec_Call:
+		{
+			const C3Di_RecCall* p = (const C3Di_RecCall*)data;
+			p->func(p->data);
+			break;
+		}
+		case C3Di_Rec_CmdList:
+			C3D_CmdListExecute(*(const C3D_CmdList* const*)data);
+			break;
+	}
+}
+
+static void C3Di_RecData(C3D_Recorder* rec, u16 op, const void* data, size_t size)
+{
+	void* p = rec->begin(rec, op, size);
+	if (!p)
+		return;
+	memcpy(p, data, size);
+	rec->commit(rec);
+}
+
+void C3D_RecFrameBegin(C3D_Recorder* rec, u8 flags)
+{
+	C3Di_RecData(rec, C3Di_Rec_FrameBegin, &flags, sizeof(flags));
+}
+
+void C3D_RecFrameDrawOn(C3D_Recorder* rec, C3D_RenderTarget* target)
+{
+	C3Di_RecData(rec, C3Di_Rec_FrameDrawOn, &target, sizeof(target));
+}
+
+void C3D_RecFrameEnd(C3D_Recorder* rec, u8 flags)
+{
+	C3Di_RecData(rec, C3Di_Rec_FrameEnd, &flags, sizeof(flags));
+}
+
+void C3D_RecRenderTargetClear(C3D_Recorder* rec, C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	C3Di_RecClear p = { target, clearBits, clearColor, clearDepth };
+	C3Di_RecData(rec, C3Di_Rec_TargetClear, &p, sizeof(p));
+}
+
+void C3D_RecBindProgram(C3D_Recorder* rec, shaderProgram_s* program)
+{
+	C3Di_RecData(rec, C3Di_Rec_BindProgram, &program, sizeof(program));
+}
+
+void C3D_RecSetAttrInfo(C3D_Recorder* rec, const C3D_AttrInfo* info)
+{
+	C3Di_RecData(rec, C3Di_Rec_AttrInfo, info, sizeof(*info));
+}
+
+void C3D_RecSetBufInfo(C3D_Recorder* rec, const C3D_BufInfo* info)
+{
+	C3Di_RecData(rec, C3Di_Rec_BufInfo, info, sizeof(*info));
+}
+
+void C3D_RecSetTexEnv(C3D_Recorder* rec, int id, const C3D_TexEnv* env)
+{
+	C3Di_RecTexEnv p = { id, *env };
+	C3Di_RecData(rec, C3Di_Rec_TexEnv, &p, sizeof(p));
+}
+
+void C3D_RecTexBind(C3D_Recorder* rec, int unitId, C3D_Tex* tex)
+{
+	C3Di_RecTexBind p = { unitId, tex };
+	C3Di_RecData(rec, C3Di_Rec_TexBind, &p, sizeof(p));
+}
+
+void C3D_RecFVUnifMtxNx4(C3D_Recorder* rec, GPU_SHADER_TYPE type, int id, const C3D_Mtx* mtx, int num)
+{
+	C3Di_RecFVUnif* p = (C3Di_RecFVUnif*)rec->begin(rec, C3Di_Rec_FVUnif, sizeof(C3Di_RecFVUnif) + num*sizeof(C3D_FVec));
+	if (!p)
+		return;
+	p->type = type;
+	p->id = id;
+	p->num = num;
+	memcpy(p->vec, mtx->r, num*sizeof(C3D_FVec));
+	rec->commit(rec);
+}
+
+void C3D_RecFVUnifSet(C3D_Recorder* rec, GPU_SHADER_TYPE type, int id, float x, float y, float z, float w)
+{
+	C3Di_RecFVUnif* p = (C3Di_RecFVUnif*)rec->begin(rec, C3Di_Rec_FVUnif, sizeof(C3Di_RecFVUnif) + sizeof(C3D_FVec));
+	if (!p)
+		return;
+	p->type = type;
+	p->id = id;
+	p->num = 1;
+	p->vec[0] = FVec4_New(x, y, z, w);
+	rec->commit(rec);
+}
+
+void C3D_RecDrawArrays(C3D_Recorder* rec, GPU_Primitive_t primitive, int first, int size)
+{
+	C3Di_RecDraw p = { primitive, first, size, 0, NULL };
+	C3Di_RecData(rec, C3Di_Rec_DrawArrays, &p, sizeof(p));
+}
+
+void C3D_RecDrawElements(C3D_Recorder* rec, GPU_Primitive_t primitive, int count, int type, const void* indices)
+{
+	C3Di_RecDraw p = { primitive, 0, count, type, indices };
+	C3Di_RecData(rec, C3Di_Rec_DrawElements, &p, sizeof(p));
+}
+
+void C3D_RecCall(C3D_Recorder* rec, C3D_RecFunc func, const void* data, size_t size)
+{
+	C3Di_RecCall* p = (C3Di_RecCall*)rec->begin(rec, C3Di_Rec_Call, sizeof(C3Di_RecCall) + size);
+	if (!p)
+		return;
+	p->func = func;
+	if (size)
+		memcpy(p->data, data, size);
+	rec->commit(rec);
+}
+
+void C3D_RecCmdList(C3D_Recorder* rec, const C3D_CmdList* list)
+{
+	C3Di_RecData(rec, C3Di_Rec_CmdList, &list, sizeof(list));
+}
+
+static void* C3Di_CmdListBegin(C3D_Recorder* rec, u16 op, size_t size)
+{
+	C3D_CmdList* list = (C3D_CmdList*)rec;
+	u32 need = C3D_PACKET_SIZE(size);
+	if (size > 0xFFFF)
+		goto _fail;
+
+	if (list->size - list->used < need)
+	{
+		u32 newSize = list->size ? 2*list->size : 4096;
+		while (newSize - list->used < need)
+			newSize *= 2;
+		u8* newBuf = (u8*)realloc(list->buf, newSize);
+		if (!newBuf)
+			goto _fail;
+		list->buf = newBuf;
+		list->size = newSize;
+	}
+
+	C3D_PacketHeader* hdr = (C3D_PacketHeader*)&list->buf[list->used];
+	hdr->op = op;
+	hdr->size = size;
+	list->reserve = list->used + need;
+	return hdr+1;
+
+_fail:
+	list->overflow = true;
+	return NULL;
+}
+
+static void C3Di_CmdListCommit(C3D_Recorder* rec)
+{
+	C3D_CmdList* list = (C3D_CmdList*)rec;
+	list->used = list->reserve;
+	list->packets++;
+}
+
+bool C3D_CmdListInit(C3D_CmdList* list, u32 initialSize)
+{
+	memset(list, 0, sizeof(*list));
+	list->rec.begin = C3Di_CmdListBegin;
+	list->rec.commit = C3Di_CmdListCommit;
+	if (!initialSize)
+		return true;
+
+	list->buf = (u8*)malloc(initialSize);
+	if (!list->buf)
+		return false;
+	list->size = initialSize;
+	return true;
+}
+
+void C3D_CmdListFree(C3D_CmdList* list)
+{
+	free(list->buf);
+	list->buf = NULL;
+	list->size = 0;
+	C3D_CmdListReset(list);
+}
+
+void C3D_CmdListReset(C3D_CmdList* list)
+{
+	list->used = 0;
+	list->packets = 0;
+	list->overflow = false;
+}
+
+void C3D_CmdListExecute(const C3D_CmdList* list)
+{
+	u32 off = 0;
+	while (off < list->used)
+	{
+		const C3D_PacketHeader* hdr = (const C3D_PacketHeader*)&list->buf[off];
+		C3Di_RecReplay(hdr->op, hdr+1);
+		off += C3D_PACKET_SIZE(hdr->size);
+	}
+}
@@ -1,6 +1,8 @@
 #include "internal.h"
 #include <c3d/base.h>
 #include <c3d/renderqueue.h>
+#include <c3d/profile.h>
+#include <c3d/framestats.h>
 #include <stdlib.h>
 
 static C3D_RenderTarget *firstTarget, *lastTarget;
@@ -10,13 +12,69 @@ static TickCounter gpuTime, cpuTime;
 
 static bool inFrame, inSafeTransfer, measureGpuTime;
 static bool needSwapTop, needSwapBot, isTopStereo;
-static float framerate = 60.0f;
+static float framerate = 60.0f, userFramerate = 60.0f; // Effective rate, and the one set by C3D_FrameRate
 static float framerateCounter[2] = { 60.0f, 60.0f };
 static u32 frameCounter[2];
 static void (* frameEndCb)(void*);
 static void* frameEndCbData;
+static volatile u32 queueEpoch;
 
-static void C3Di_RenderTargetDestroy(C3D_RenderTarget* target);
+#define C3Di_VBLANK_MS         (1000.0f*4481136/SYSCLOCK_ARM11)
+#define C3Di_PACING_HISTORY    8
+#define C3Di_PACING_DROP_COUNT 4  // Consecutive late frames before falling back to 30 fps
+#define C3Di_PACING_RISE_COUNT 60 // Consecutive fast frames before going back to 60 fps
+
+static C3D_PacingMode pacingMode;
+static float pacingMargin = 1.0f;
+static float pacingHistory[C3Di_PACING_HISTORY];
+static u32 pacingSamples;
+static int pacingOver, pacingUnder;
+static u32 pacingAdapted;
+static volatile u64 vblankTick;
+static u64 syncTick;
+static bool frameSynced;
+static float frameCpuMs;
+
+static volatile u32 vblankCount, swapVblank;
+static volatile bool frameSwapped;
+static u32 lastSwapVblank;
+static bool lastSwapValid, frameRecorded = true;
+static u32 frameCmdWords;
+
+static u32 autoSplitWords, autoSplitDraws, frameDraws;
+static bool queueKicked;
+
+static C3D_QueueStats queueStats;
+
+static C3D_ClearQuadFunc clearQuadFunc;
+static void* clearQuadParam;
+static C3D_UpscaleFunc upscaleFunc;
+static void* upscaleParam;
+
+#define C3Di_RES_RISE_COUNT 60 // Consecutive frames with headroom before raising the resolution
+#define C3Di_RES_HEADROOM    0.8f
+
+#define C3Di_POOL_MAX_BLOCKS  16
+#define C3Di_POOL_TRIM_FRAMES 120 // Frames a pool block may stay unused before being freed
+
+typedef struct
+{
+	void* mem;
+	u32 size;
+	u32 lastUsed;
+	bool inUse;
+} C3Di_PoolBlock;
+
+static C3Di_PoolBlock poolBlocks[C3Di_POOL_MAX_BLOCKS];
+static int numPoolBlocks;
+static u32 poolFrame;
+
+static void C3Di_PoolTrim(u32 maxAge);
+
+#define C3Di_GXCMD_MEMORYFILL  0x02
+#define C3Di_GXCMD_TEXTURECOPY 0x04
+
+#define C3Di_FENCE_POLL_NS 100000
 
 static bool framerateLimit(int id)
 {
@@ -31,8 +89,12 @@ static bool framerateLimit(int id)
 
 static void onVBlank0(C3D_UNUSED void* unused)
 {
+	vblankCount++;
 	if (framerateLimit(0))
+	{
+		vblankTick = svcGetSystemTick();
 		frameCounter[0]++;
+	}
 }
 
 static void onVBlank1(C3D_UNUSED void* unused)
@@ -47,6 +109,7 @@ static void onQueueFinish(gxCmdQueue_s* queue)
 	{
 		osTickCounterUpdate(&gpuTime);
 		measureGpuTime = false;
+		pacingHistory[pacingSamples++ % C3Di_PACING_HISTORY] = frameCpuMs + osTickCounterRead(&gpuTime);
 	}
 	if (inSafeTransfer)
 	{
@@ -55,10 +118,16 @@ static void onQueueFinish(gxCmdQueue_s* queue)
 		{
 			gxCmdQueueStop(queue);
 			gxCmdQueueClear(queue);
+			queueEpoch++;
 		}
 	}
 	else
 	{
+		if (needSwapTop || needSwapBot)
+		{
+			swapVblank = vblankCount;
+			frameSwapped = true;
+		}
 		if (needSwapTop)
 		{
 			gfxScreenSwapBuffers(GFX_TOP, isTopStereo);
@@ -72,6 +141,70 @@ static void onQueueFinish(gxCmdQueue_s* queue)
 	}
 }
 
+static float C3Di_PacingPredict(void)
+{
+	int i, count = pacingSamples < C3Di_PACING_HISTORY ? pacingSamples : C3Di_PACING_HISTORY;
+	float max = 0.0f;
+	for (i = 0; i < count; i ++)
+		if (pacingHistory[i] > max)
+			max = pacingHistory[i];
+	return max;
+}
+
+static void C3Di_SetFramerate(float fps)
+{
+	framerate = fps;
+	framerateCounter[0] = fps;
+	framerateCounter[1] = fps;
+}
+
+static void C3Di_PacingAdapt(void)
+{
+	// Only count each completed frame once
+	if (!pacingSamples || pacingAdapted == pacingSamples)
+		return;
+	pacingAdapted = pacingSamples;
+
+	float last = pacingHistory[(pacingSamples-1) % C3Di_PACING_HISTORY];
+	float budget = C3Di_VBLANK_MS - pacingMargin;
+
+	// Hysteresis: drop quickly when frames run late, recover only after a long stable streak
+	if (last > budget)
+	{
+		pacingOver ++;
+		pacingUnder = 0;
+	} else if (last < budget*0.75f)
+	{
+		pacingUnder ++;
+		pacingOver = 0;
+	} else
+		pacingOver = pacingUnder = 0;
+
+	// Switch between the rate set by the application and half of it
+	if (framerate >= userFramerate && pacingOver >= C3Di_PACING_DROP_COUNT)
+	{
+		C3Di_SetFramerate(userFramerate / 2);
+		pacingOver = 0;
+	} else if (framerate < userFramerate && pacingUnder >= C3Di_PACING_RISE_COUNT)
+	{
+		C3Di_SetFramerate(userFramerate);
+		pacingUnder = 0;
+	}
+}
+
+static void C3Di_PacingDelay(void)
+{
+	if (pacingMode == C3D_PACING_ADAPTIVE)
+		C3Di_PacingAdapt();
+
+	// Start as late as possible while still completing before the next counted VBlank
+	float period = C3Di_VBLANK_MS * 60.0f / framerate;
+	float elapsed = (float)((svcGetSystemTick() - vblankTick) / CPU_TICKS_PER_MSEC);
+	float delay = period - pacingMargin - C3Di_PacingPredict() - elapsed;
+	if (pacingSamples && delay > 0.0f)
+		svcSleepThread((s64)(delay * 1000000.0f));
+}
+
 void C3D_FrameSync(void)
 {
 	u32 cur[2];
@@ -82,6 +215,22 @@ void C3D_FrameSync(void)
 		cur[0] = frameCounter[0];
 		cur[1] = frameCounter[1];
 	} while (cur[0]==start[0] || cur[1]==start[1]);
+
+	if (pacingMode != C3D_PACING_NONE)
+		C3Di_PacingDelay();
+	syncTick = svcGetSystemTick();
+	frameSynced = true;
+}
+
+void C3D_FramePacing(C3D_PacingMode mode, float marginMs)
+{
+	pacingMode = mode;
+	pacingMargin = marginMs >= 0.0f ? marginMs : 0.0f;
+	pacingSamples = 0;
+	pacingAdapted = 0;
+	pacingOver = pacingUnder = 0;
+	if (framerate != userFramerate)
+		C3Di_SetFramerate(userFramerate);
 }
 
 u32 C3D_FrameCounter(int id)
@@ -96,9 +245,259 @@ static bool C3Di_WaitAndClearQueue(s64 timeout)
 		return false;
 	gxCmdQueueStop(queue);
 	gxCmdQueueClear(queue);
+	queueEpoch++;
+	if (inFrame)
+		C3Di_ProfileQueueCleared();
 	return true;
 }
 
+static void C3Di_DynamicResApply(C3D_RenderTarget* target)
+{
+	C3D_FrameBuf* fb = &target->frameBuf;
+	if (target->resLevel <= C3D_RES_1X1)
+	{
+		fb->colorBuf = target->resColorBuf;
+		fb->width    = target->outWidth  << (target->resLevel < C3D_RES_1X1 ? 1 : 0);
+		fb->height   = target->outHeight << (target->resLevel < C3D_RES_2X1 ? 1 : 0);
+		target->resWidth  = fb->width;
+		target->resHeight = fb->height;
+	} else
+	{
+		// Drawn at the origin of the reduced frame texture, which keeps its own dimensions
+		fb->colorBuf = target->resTex->data;
+		fb->width    = target->resTex->width;
+		fb->height   = target->resTex->height;
+		target->resWidth  = (target->outWidth+1) / 2;
+		target->resHeight = target->resLevel == C3D_RES_HALF_XY ? (target->outHeight+1) / 2 : target->outHeight;
+	}
+}
+
+// Reduced levels need the application to upscale them
+static u8 C3Di_DynamicResLowest(const C3D_RenderTarget* target)
+{
+	return (target->resLowest > C3D_RES_1X1 && !upscaleFunc) ? C3D_RES_1X1 : target->resLowest;
+}
+
+static void C3Di_DynamicResUpdate(float gpuMs)
+{
+	C3D_RenderTarget* target;
+	for (target = firstTarget; target; target = target->next)
+	{
+		if (!target->dynamicRes)
+			continue;
+
+		u8 lowest = C3Di_DynamicResLowest(target);
+		if (target->resLevel > lowest)
+			target->resLevel = lowest;
+
+		// Each level halves the pixel count of the previous one
+		if (target->resBudget <= 0.0f)
+			target->resUnder = 0;
+		else if (gpuMs > target->resBudget)
+		{
+			target->resUnder = 0;
+			if (target->resLevel < lowest)
+				target->resLevel ++;
+		} else if (target->resLevel > target->resHighest && 2.0f*gpuMs < C3Di_RES_HEADROOM*target->resBudget)
+		{
+			if (++target->resUnder >= C3Di_RES_RISE_COUNT)
+			{
+				target->resUnder = 0;
+				target->resLevel --;
+			}
+		} else
+			target->resUnder = 0;
+
+		C3Di_DynamicResApply(target);
+	}
+}
+
+static void C3Di_DynamicResUpscale(C3D_RenderTarget* target)
+{
+	C3D_Tex* tex = target->resTex;
+	C3D_FrameBuf out;
+	C3D_FrameBufAttrib(&out, target->outWidth, target->outHeight, false);
+	C3D_FrameBufColor(&out, target->resColorBuf, target->frameBuf.colorFmt);
+	C3D_FrameBufDepth(&out, NULL, GPU_RB_DEPTH16);
+
+	C3Di_FrameBufBarrier();
+	C3D_SetFrameBuf(&out);
+	C3D_SetViewport(0, 0, target->outWidth, target->outHeight);
+	C3D_SetScissor(GPU_SCISSOR_DISABLE, 0, 0, 0, 0);
+	upscaleFunc(tex, (float)target->resWidth/tex->width, (float)target->resHeight/tex->height, upscaleParam);
+}
+
+static void C3Di_DynamicResTransfer(C3D_RenderTarget* target)
+{
+	static const u8 scaling[] = { GX_TRANSFER_SCALE_XY, GX_TRANSFER_SCALE_X, GX_TRANSFER_SCALE_NO };
+	u32* outputFrameBuf = (u32*)gfxGetFramebuffer(target->screen, target->side, NULL, NULL);
+
+	// Reduced frames were upscaled into the full size buffer
+	u8 level = target->resLevel < C3D_RES_1X1 ? target->resLevel : C3D_RES_1X1;
+	u32 width  = level < C3D_RES_1X1 ? target->frameBuf.width  : target->outWidth;
+	u32 height = level < C3D_RES_1X1 ? target->frameBuf.height : target->outHeight;
+	u32 flags = (target->transferFlags &~ GX_TRANSFER_SCALING(3)) | GX_TRANSFER_SCALING(scaling[level]);
+	GX_DisplayTransfer((u32*)target->resColorBuf, GX_BUFFER_DIM(width, height),
+		outputFrameBuf, GX_BUFFER_DIM((u32)target->outWidth, (u32)target->outHeight), flags);
+}
+
+static void C3Di_FrameStatsCollect(void)
+{
+	C3D_FrameStats stats;
+	if (frameRecorded)
+		return;
+	frameRecorded = true;
+
+	stats.cpuTime = osTickCounterRead(&cpuTime);
+	stats.gpuTime = osTickCounterRead(&gpuTime);
+	stats.cmdWords = frameCmdWords;
+	stats.vblankMisses = 0;
+
+	// A frame presented later than its expected VBlank interval counts the extra VBlanks as misses
+	if (frameSwapped)
+	{
+		u32 expected = (u32)(60.0f / framerate + 0.5f);
+		u32 interval = swapVblank - lastSwapVblank;
+		if (lastSwapValid && interval > expected)
+			stats.vblankMisses = interval - expected;
+		lastSwapVblank = swapVblank;
+		lastSwapValid = true;
+		frameSwapped = false;
+	}
+
+	C3Di_FrameStatsRecord(&stats);
+}
+
+static u32 C3Di_CmdBufWords(void)
+{
+	u32* cmdBuf;
+	u32 offset;
+	if (!inFrame)
+		return frameCmdWords;
+	GPUCMD_GetBuffer(&cmdBuf, NULL, &offset);
+	return cmdBuf + offset - C3Di_GetContext()->cmdBuf;
+}
+
+static void C3Di_FlushWholeHeap(void)
+{
+	extern u32 __ctru_linear_heap;
+	extern u32 __ctru_linear_heap_size;
+	GSPGPU_FlushDataCache((void*)__ctru_linear_heap, __ctru_linear_heap_size);
+}
+
+static void C3Di_FlushLinearHeap(void)
+{
+	// With flush tracking, only the recorded ranges and the frame's command lists are flushed
+	C3D_FlushRange(C3Di_GetContext()->cmdBuf, C3Di_CmdBufWords()*4);
+	if (!C3Di_FlushTracked())
+		C3Di_FlushWholeHeap();
+}
+
+// Starts the GPU on the commands submitted so far, without waiting for C3D_FrameEnd
+static void C3Di_KickQueue(void)
+{
+	if (queueKicked)
+		return;
+	C3Di_FlushLinearHeap();
+	C3Di_ProfileQueueRun();
+	osTickCounterStart(&gpuTime);
+	gxCmdQueueRun(&C3Di_GetContext()->gxQueue);
+	queueKicked = true;
+}
+
+static void C3Di_QueueUpdatePeak(void)
+{
+	u16 used = C3Di_GetContext()->gxQueue.numEntries;
+	queueStats.used = used;
+	if (used > queueStats.peak)
+		queueStats.peak = used;
+}
+
+// Makes room for one more queue entry, waiting for the GPU if the queue is full
+static bool C3Di_QueueReserve(bool restart)
+{
+	gxCmdQueue_s* queue = &C3Di_GetContext()->gxQueue;
+	if (queue->numEntries < queue->maxEntries)
+		return false;
+
+	queueStats.fullWaits++;
+	C3Di_FlushLinearHeap();
+	C3Di_ProfileQueueRun();
+	gxCmdQueueRun(queue);
+	C3Di_WaitAndClearQueue(-1);
+	queueKicked = false;
+	if (restart)
+		gxCmdQueueRun(queue);
+	return true;
+}
+
+// Returns the last queue entry if it is of the given type and may still be rewritten
+static gxCmdEntry_s* C3Di_QueueLastPending(u32 type)
+{
+	gxCmdQueue_s* queue = &C3Di_GetContext()->gxQueue;
+
+	// Only while the queue is held back until C3D_FrameEnd, so the GPU cannot be picking it up
+	if (!inFrame || queueKicked || !queue->numEntries || queue->numEntries-1 < queue->curEntry)
+		return NULL;
+
+	gxCmdEntry_s* entry = &queue->entries[queue->numEntries-1];
+	return (entry->data[0] & 0xFF) == type ? entry : NULL;
+}
+
+void C3Di_QueueMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* buf1a, u32 buf1v, u32* buf1e, u16 control1)
+{
+	// Two single-buffer fills in a row can share one command, running on both fill units
+	gxCmdEntry_s* prev = buf1a ? NULL : C3Di_QueueLastPending(C3Di_GXCMD_MEMORYFILL);
+	if (prev && !prev->data[4] && ((u32)buf0e <= prev->data[1] || (u32)buf0a >= prev->data[3]))
+	{
+		prev->data[4] = (u32)buf0a;
+		prev->data[5] = buf0v;
+		prev->data[6] = (u32)buf0e;
+		prev->data[7] |= (u32)control0 << 16;
+		queueStats.merged++;
+		return;
+	}
+
+	C3Di_QueueReserve(!inFrame);
+	GX_MemoryFill(buf0a, buf0v, buf0e, control0, buf1a, buf1v, buf1e, control1);
+	C3Di_QueueUpdatePeak();
+}
+
+void C3Di_QueueTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags)
+{
+	// Linear copies continuing the previous one on both sides extend it
+	gxCmdEntry_s* prev = (indim || outdim) ? NULL : C3Di_QueueLastPending(C3Di_GXCMD_TEXTURECOPY);
+	if (prev && !prev->data[4] && !prev->data[5] && prev->data[6] == flags &&
+		prev->data[1] + prev->data[3] == (u32)inadr && prev->data[2] + prev->data[3] == (u32)outadr)
+	{
+		prev->data[3] += size;
+		queueStats.merged++;
+		return;
+	}
+
+	C3Di_QueueReserve(!inFrame);
+	GX_TextureCopy(inadr, indim, outadr, outdim, size, flags);
+	C3Di_QueueUpdatePeak();
+}
+
+static void C3Di_QueueDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags)
+{
+	C3Di_QueueReserve(!inFrame);
+	GX_DisplayTransfer(inadr, indim, outadr, outdim, flags);
+	C3Di_QueueUpdatePeak();
+}
+
+void C3D_GetQueueStats(C3D_QueueStats* stats)
+{
+	queueStats.depth = C3Di_GetContext()->gxQueue.maxEntries;
+	*stats = queueStats;
+}
+
+void C3D_ResetQueueStats(void)
+{
+	memset(&queueStats, 0, sizeof(queueStats));
+}
+
 void C3Di_RenderQueueEnableVBlank(void)
 {
 	gspSetEventCallback(GSPGPU_EVENT_VBlank0, onVBlank0, NULL, false);
@@ -128,6 +527,8 @@ void C3Di_RenderQueueExit(void)
 	C3D_RenderTarget *a, *next;
 
 	C3Di_WaitAndClearQueue(-1);
+	C3Di_DeferredCollect(true);
+	C3D_ProfileEnable(false);
 	gxCmdQueueSetCallback(&C3Di_GetContext()->gxQueue, NULL, NULL);
 	GX_BindQueue(NULL);
 
@@ -141,6 +542,10 @@ void C3Di_RenderQueueExit(void)
 		next = a->next;
 		C3Di_RenderTargetDestroy(a);
 	}
+
+	for (i = 0; i < numPoolBlocks; i ++)
+		vramFree(poolBlocks[i].mem);
+	numPoolBlocks = 0;
 }
 
 void C3Di_RenderQueueWaitDone(void)
@@ -148,14 +553,19 @@ void C3Di_RenderQueueWaitDone(void)
 	C3Di_WaitAndClearQueue(-1);
 }
 
+bool C3Di_InFrame(void)
+{
+	return inFrame;
+}
+
 float C3D_FrameRate(float fps)
 {
-	float old = framerate;
+	float old = userFramerate;
 	if (fps > 0.0f && fps <= 60.0f)
 	{
-		framerate = fps;
-		framerateCounter[0] = fps;
-		framerateCounter[1] = fps;
+		userFramerate = fps;
+		C3Di_SetFramerate(fps);
+		pacingOver = pacingUnder = 0;
 	}
 	return old;
 }
@@ -170,7 +580,16 @@ bool C3D_FrameBegin(u8 flags)
 	if (!C3Di_WaitAndClearQueue((flags & C3D_FRAME_NONBLOCK) ? 0 : -1))
 		return false;
 
+	C3Di_ProfileFrameBegin();
+	if (!frameRecorded)
+		C3Di_DynamicResUpdate(osTickCounterRead(&gpuTime));
+	C3Di_FrameStatsCollect();
+	C3Di_DeferredCollect(false);
+	poolFrame++;
+	C3Di_PoolTrim(C3Di_POOL_TRIM_FRAMES);
 	inFrame = true;
+	queueKicked = false;
+	frameDraws = 0;
 	osTickCounterStart(&cpuTime);
 	GPUCMD_SetBuffer(ctx->cmdBuf, ctx->cmdBufSize, 0);
 	return true;
@@ -180,9 +599,32 @@ bool C3D_FrameDrawOn(C3D_RenderTarget* target)
 {
 	if (!inFrame) return false;
 
-	target->used = true;
 	C3D_SetFrameBuf(&target->frameBuf);
-	C3D_SetViewport(0, 0, target->frameBuf.width, target->frameBuf.height);
+	if (target->dynamicRes)
+		C3D_SetViewport(0, 0, target->resWidth, target->resHeight);
+	else
+		C3D_SetViewport(0, 0, target->frameBuf.width, target->frameBuf.height);
+
+	C3D_Context* ctx = C3Di_GetContext();
+	u8 depthPhase = target->depthAlternate ? 1+target->depthPhase : 0;
+	if (ctx->depthPhase != depthPhase)
+	{
+		ctx->depthPhase = depthPhase;
+		ctx->flags |= C3DiF_Effect;
+	}
+
+	if (target->trackDirty)
+	{
+		if (!C3D_RenderTargetIsDirty(target))
+		{
+			// Still bind the target, but let nothing through
+			C3D_SetScissor(GPU_SCISSOR_INVERT, 0, 0, target->frameBuf.width, target->frameBuf.height);
+			return false;
+		}
+		C3D_SetScissor(GPU_SCISSOR_NORMAL, 0, target->dirtyY0, target->frameBuf.width, target->dirtyY1);
+	}
+	target->used = true;
+	target->depthDrawn = true;
 	return true;
 }
 
@@ -190,8 +632,42 @@ void C3D_FrameSplit(u8 flags)
 {
 	u32 *cmdBuf, cmdBufSize;
 	if (!inFrame) return;
+	frameDraws = 0;
+
+	// The GPU may already be running: the new command list is flushed through GX_CMDLIST_FLUSH,
+	// other data only if tracked, as a full heap flush per split would outweigh the overlap
+	if (queueKicked && gpuCmdBufOffset)
+	{
+		if (C3Di_FlushTrackingEnabled() && !C3Di_FlushTracked())
+			C3Di_FlushWholeHeap();
+		flags |= GX_CMDLIST_FLUSH;
+	}
 	if (C3Di_SplitFrame(&cmdBuf, &cmdBufSize))
+	{
+		if (C3Di_QueueReserve(false))
+			flags |= GX_CMDLIST_FLUSH;
 		GX_ProcessCommandList(cmdBuf, cmdBufSize*4, flags);
+		C3Di_QueueUpdatePeak();
+	}
+}
+
+void C3D_FrameAutoSplit(u32 words, u32 draws)
+{
+	autoSplitWords = words;
+	autoSplitDraws = draws;
+}
+
+void C3Di_FrameDrawDone(void)
+{
+	if (!inFrame || (!autoSplitWords && !autoSplitDraws))
+		return;
+
+	frameDraws++;
+	if ((autoSplitDraws && frameDraws >= autoSplitDraws) || (autoSplitWords && gpuCmdBufOffset >= autoSplitWords))
+	{
+		C3D_FrameSplit(0);
+		C3Di_KickQueue();
+	}
 }
 
 void C3D_FrameEnd(u8 flags)
@@ -202,21 +678,63 @@ void C3D_FrameEnd(u8 flags)
 	if (frameEndCb)
 		frameEndCb(frameEndCbData);
 
+	int i;
+	C3D_RenderTarget* target;
+	for (i = 0; i < 3; i ++)
+	{
+		target = linkedTarget[i];
+		if (target && target->used && target->dynamicRes && target->resLevel > C3D_RES_1X1 && upscaleFunc)
+			C3Di_DynamicResUpscale(target);
+	}
+
+	// Hold back an early started queue so the buffer swap is only armed once the frame is complete
+	bool kicked = queueKicked;
+	if (kicked)
+		gxCmdQueueStop(&ctx->gxQueue);
+
 	C3D_FrameSplit(flags);
+	u32* cmdBufEnd;
+	GPUCMD_GetBuffer(&cmdBufEnd, NULL, NULL);
+	frameCmdWords = cmdBufEnd - ctx->cmdBuf;
 	GPUCMD_SetBuffer(NULL, 0, 0);
 	osTickCounterUpdate(&cpuTime);
 	inFrame = false;
+	frameRecorded = false;
+
+	// When synced, the CPU side of the frame includes the work done before C3D_FrameBegin
+	if (frameSynced)
+		frameCpuMs = (float)((svcGetSystemTick() - syncTick) / CPU_TICKS_PER_MSEC);
+	else
+		frameCpuMs = osTickCounterRead(&cpuTime);
+	frameSynced = false;
 
 	// Flush the entire linear memory if the user did not explicitly mandate to flush the command list
-	if (!(flags & GX_CMDLIST_FLUSH))
+	if (!kicked && !(flags & GX_CMDLIST_FLUSH))
+		C3Di_FlushLinearHeap();
+
+	for (target = firstTarget; target; target = target->next)
 	{
-		extern u32 __ctru_linear_heap;
-		extern u32 __ctru_linear_heap_size;
-		GSPGPU_FlushDataCache((void*)__ctru_linear_heap, __ctru_linear_heap_size);
+		if (!target->trackDirty || !target->used)
+			continue;
+		// The dirty band has been redrawn; linked targets are still transferred below
+		target->dirtyY0 = target->dirtyY1 = 0;
+		if (!target->linked)
+			target->used = false;
+	}
+
+	// A stereo pair is swapped as a whole: if one eye was redrawn, transfer the other
+	// too when it is merely clean, or the screen would go mono and the other half of
+	// the back buffer would be stale. An untracked eye left undrawn still means mono.
+	C3D_RenderTarget* left = linkedTarget[0];
+	C3D_RenderTarget* right = linkedTarget[1];
+	if (left && right && (left->used || right->used))
+	{
+		if (left->trackDirty)
+			left->used = true;
+		if (right->trackDirty)
+			right->used = true;
 	}
 
-	int i;
-	C3D_RenderTarget* target;
 	isTopStereo = false;
 	for (i = 2; i >= 0; i --)
 	{
@@ -224,7 +742,11 @@ void C3D_FrameEnd(u8 flags)
 		if (!target || !target->used)
 			continue;
 		target->used = false;
-		C3D_FrameBufTransfer(&target->frameBuf, target->screen, target->side, target->transferFlags);
+		C3Di_QueueReserve(false);
+		if (target->dynamicRes)
+			C3Di_DynamicResTransfer(target);
+		else
+			C3D_FrameBufTransfer(&target->frameBuf, target->screen, target->side, target->transferFlags);
 		if (target->screen == GFX_TOP)
 		{
 			needSwapTop = true;
@@ -235,8 +757,21 @@ void C3D_FrameEnd(u8 flags)
 			needSwapBot = true;
 	}
 
+	C3D_RenderTarget* next;
+	for (target = firstTarget; target; target = next)
+	{
+		next = target->next;
+		if (target->transient)
+			C3D_RenderTargetRelease(target);
+	}
+
+	C3Di_QueueUpdatePeak();
+	C3Di_DeferredFrameEnd();
+	// A frame started early was timed from the kick
 	measureGpuTime = true;
-	osTickCounterStart(&gpuTime);
+	if (!kicked)
+		osTickCounterStart(&gpuTime);
+	C3Di_ProfileQueueRun();
 	gxCmdQueueRun(&ctx->gxQueue);
 }
 
@@ -246,6 +781,55 @@ void C3D_FrameEndHook(void (* hook)(void*), void* param)
 	frameEndCbData = param;
 }
 
+C3D_Fence C3D_FenceInsert(void)
+{
+	C3D_Fence fence;
+
+	// Commands recorded so far in this frame must be in the queue to be tracked
+	if (inFrame)
+		C3D_FrameSplit(0);
+
+	fence.epoch = queueEpoch;
+	fence.entry = C3Di_GetContext()->gxQueue.numEntries;
+	return fence;
+}
+
+bool C3D_FenceSignaled(C3D_Fence fence)
+{
+	// The queue is only ever cleared once everything in it has completed
+	if (queueEpoch != fence.epoch)
+		return true;
+	bool done = C3Di_GetContext()->gxQueue.lastEntry >= fence.entry;
+	return done || queueEpoch != fence.epoch;
+}
+
+bool C3D_FenceWait(C3D_Fence fence, s64 timeout)
+{
+	gxCmdQueue_s* queue = &C3Di_GetContext()->gxQueue;
+	if (C3D_FenceSignaled(fence))
+		return true;
+	if (!timeout)
+		return false;
+
+	// Within a frame the queue only starts at C3D_FrameEnd; kick it now so the fence can complete
+	if (inFrame)
+		C3Di_KickQueue();
+
+	// A fence covering the whole queue can use the queue's own wait
+	if (fence.entry >= queue->numEntries)
+		return gxCmdQueueWait(queue, timeout) || C3D_FenceSignaled(fence);
+
+	while (!C3D_FenceSignaled(fence))
+	{
+		if (timeout >= 0 && timeout < C3Di_FENCE_POLL_NS)
+			return false;
+		svcSleepThread(C3Di_FENCE_POLL_NS);
+		if (timeout > 0)
+			timeout -= C3Di_FENCE_POLL_NS;
+	}
+	return true;
+}
+
 float C3D_GetDrawingTime(void)
 {
 	return osTickCounterRead(&gpuTime);
@@ -275,6 +859,24 @@ static void C3Di_RenderTargetFinishInit(C3D_RenderTarget* target)
 	lastTarget = target;
 }
 
+C3D_RenderTarget* C3Di_RenderTargetFromBuffers(int width, int height, void* colorBuf, GPU_COLORBUF colorFmt, void* depthBuf, GPU_DEPTHBUF depthFmt)
+{
+	C3D_RenderTarget* target = C3Di_RenderTargetNew();
+	if (!target) return NULL;
+
+	C3D_FrameBuf* fb = &target->frameBuf;
+	C3D_FrameBufAttrib(fb, width, height, false);
+	C3D_FrameBufColor(fb, colorBuf, colorFmt);
+	target->ownsColor = true;
+	if (depthBuf)
+	{
+		C3D_FrameBufDepth(fb, depthBuf, depthFmt);
+		target->ownsDepth = true;
+	}
+	C3Di_RenderTargetFinishInit(target);
+	return target;
+}
+
 C3D_RenderTarget* C3D_RenderTargetCreate(int width, int height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt)
 {
 	GPU_DEPTHBUF depthFmtReal = GPU_RB_DEPTH16;
@@ -291,19 +893,8 @@ C3D_RenderTarget* C3D_RenderTargetCreate(int width, int height, GPU_COLORBUF col
 		if (!depthBuf) goto _fail1;
 	}
 
-	C3D_RenderTarget* target = C3Di_RenderTargetNew();
+	C3D_RenderTarget* target = C3Di_RenderTargetFromBuffers(width, height, colorBuf, colorFmt, depthBuf, depthFmtReal);
 	if (!target) goto _fail2;
-
-	C3D_FrameBuf* fb = &target->frameBuf;
-	C3D_FrameBufAttrib(fb, width, height, false);
-	C3D_FrameBufColor(fb, colorBuf, colorFmt);
-	target->ownsColor = true;
-	if (depthBuf)
-	{
-		C3D_FrameBufDepth(fb, depthBuf, depthFmtReal);
-		target->ownsDepth = true;
-	}
-	C3Di_RenderTargetFinishInit(target);
 	return target;
 
 _fail2:
@@ -314,6 +905,199 @@ _fail0:
 	return NULL;
 }
 
+static u32 C3Di_NextPow2(u32 x)
+{
+	u32 p = 8; // Smallest texture dimension
+	while (p < x)
+		p <<= 1;
+	return p;
+}
+
+C3D_RenderTarget* C3D_RenderTargetCreateDynamic(int width, int height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt, C3D_ResLevel highest, C3D_ResLevel lowest)
+{
+	if (highest > C3D_RES_1X1) highest = C3D_RES_1X1;
+	if (lowest < C3D_RES_1X1) lowest = C3D_RES_1X1;
+	if (lowest > C3D_RES_HALF_XY) lowest = C3D_RES_HALF_XY;
+
+	int allocWidth  = width  << (highest < C3D_RES_1X1 ? 1 : 0);
+	int allocHeight = height << (highest < C3D_RES_2X1 ? 1 : 0);
+	C3D_RenderTarget* target = C3D_RenderTargetCreate(allocWidth, allocHeight, colorFmt, depthFmt);
+	if (!target) return NULL;
+
+	target->dynamicRes  = true;
+	target->resLevel    = C3D_RES_1X1;
+	target->resHighest  = highest;
+	target->resLowest   = lowest;
+	target->outWidth    = width;
+	target->outHeight   = height;
+	target->resColorBuf = target->frameBuf.colorBuf;
+	target->resBudget   = 1000.0f/60 - 1.0f;
+
+	if (lowest > C3D_RES_1X1)
+	{
+		// The reduced frame shares the depth buffer, so it has to fit in the allocation
+		u32 texWidth = C3Di_NextPow2((width+1)/2), texHeight = C3Di_NextPow2(height);
+		if (texWidth*texHeight > (u32)allocWidth*allocHeight)
+			goto _fail;
+		target->resTex = (C3D_Tex*)malloc(sizeof(C3D_Tex));
+		if (!target->resTex)
+			goto _fail;
+		if (!C3D_TexInitVRAM(target->resTex, texWidth, texHeight, (GPU_TEXCOLOR)colorFmt))
+		{
+			free(target->resTex);
+			target->resTex = NULL;
+			goto _fail;
+		}
+	}
+
+	C3Di_DynamicResApply(target);
+	return target;
+
+_fail:
+	C3Di_RenderTargetDestroy(target);
+	return NULL;
+}
+
+void C3D_RenderTargetResBudget(C3D_RenderTarget* target, float gpuMs)
+{
+	target->resBudget = gpuMs;
+	target->resUnder = 0;
+}
+
+void C3D_RenderTargetResLevel(C3D_RenderTarget* target, C3D_ResLevel level)
+{
+	if (!target->dynamicRes || level < target->resHighest || level > target->resLowest)
+		return;
+	target->resLevel = level;
+	target->resUnder = 0;
+	C3Di_DynamicResApply(target);
+}
+
+static void* C3Di_PoolAlloc(u32 size, vramAllocPos avoidBank)
+{
+	int i, best = -1;
+
+	// Best fit among the free blocks, preferring the bank not used by the other buffer
+	for (i = 0; i < numPoolBlocks; i ++)
+	{
+		C3Di_PoolBlock* b = &poolBlocks[i];
+		if (b->inUse || b->size < size)
+			continue;
+		if (best < 0)
+		{
+			best = i;
+			continue;
+		}
+		bool bankOk = addrGetVRAMBank(b->mem) != avoidBank;
+		bool bestBankOk = addrGetVRAMBank(poolBlocks[best].mem) != avoidBank;
+		if (bankOk > bestBankOk || (bankOk == bestBankOk && b->size < poolBlocks[best].size))
+			best = i;
+	}
+
+	if (best < 0)
+	{
+		if (numPoolBlocks == C3Di_POOL_MAX_BLOCKS)
+			return NULL;
+		void* mem = vramAllocAt(size, avoidBank ^ VRAM_ALLOC_ANY);
+		if (!mem) mem = vramAlloc(size);
+		if (!mem) return NULL;
+		best = numPoolBlocks++;
+		poolBlocks[best].mem = mem;
+		poolBlocks[best].size = size;
+	}
+
+	poolBlocks[best].inUse = true;
+	poolBlocks[best].lastUsed = poolFrame;
+	return poolBlocks[best].mem;
+}
+
+static void C3Di_PoolFree(void* mem)
+{
+	int i;
+	for (i = 0; i < numPoolBlocks; i ++)
+	{
+		if (poolBlocks[i].mem == mem)
+		{
+			poolBlocks[i].inUse = false;
+			poolBlocks[i].lastUsed = poolFrame;
+			return;
+		}
+	}
+}
+
+static void C3Di_PoolTrim(u32 maxAge)
+{
+	int i, j = 0;
+	for (i = 0; i < numPoolBlocks; i ++)
+	{
+		C3Di_PoolBlock* b = &poolBlocks[i];
+		if (!b->inUse && poolFrame - b->lastUsed >= maxAge)
+			C3D_FreeDeferred(b->mem);
+		else
+			poolBlocks[j++] = *b;
+	}
+	numPoolBlocks = j;
+}
+
+C3D_RenderTarget* C3D_RenderTargetAcquire(int width, int height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt)
+{
+	void* depthBuf = NULL;
+	void* colorBuf = C3Di_PoolAlloc(C3D_CalcColorBufSize(width,height,colorFmt), VRAM_ALLOC_ANY);
+	if (!colorBuf) return NULL;
+	if (C3D_DEPTHTYPE_OK(depthFmt))
+	{
+		depthBuf = C3Di_PoolAlloc(C3D_CalcDepthBufSize(width,height,C3D_DEPTHTYPE_VAL(depthFmt)), addrGetVRAMBank(colorBuf));
+		if (!depthBuf)
+		{
+			C3Di_PoolFree(colorBuf);
+			return NULL;
+		}
+	}
+
+	C3D_RenderTarget* target = C3Di_RenderTargetNew();
+	if (!target)
+	{
+		C3Di_PoolFree(colorBuf);
+		if (depthBuf) C3Di_PoolFree(depthBuf);
+		return NULL;
+	}
+
+	C3D_FrameBuf* fb = &target->frameBuf;
+	C3D_FrameBufAttrib(fb, width, height, false);
+	C3D_FrameBufColor(fb, colorBuf, colorFmt);
+	if (depthBuf)
+		C3D_FrameBufDepth(fb, depthBuf, C3D_DEPTHTYPE_VAL(depthFmt));
+	target->transient = true;
+	C3Di_RenderTargetFinishInit(target);
+	return target;
+}
+
+void C3D_RenderTargetRelease(C3D_RenderTarget* target)
+{
+	int i;
+	if (!target->transient)
+		return;
+
+	for (i = 0; i < 3; i ++)
+		if (linkedTarget[i] == target)
+			linkedTarget[i] = NULL;
+
+	// Fills and transfers are queued right away, while draws only are at the next split:
+	// queue the work done with the blocks now, so it runs before whatever their next owner does
+	if (inFrame)
+		C3D_FrameSplit(0);
+
+	C3Di_PoolFree(target->frameBuf.colorBuf);
+	if (target->frameBuf.depthBuf)
+		C3Di_PoolFree(target->frameBuf.depthBuf);
+	C3Di_RenderTargetDestroy(target);
+}
+
+void C3D_RenderTargetPoolTrim(void)
+{
+	C3Di_PoolTrim(0);
+}
+
 C3D_RenderTarget* C3D_RenderTargetCreateFromTex(C3D_Tex* tex, GPU_TEXFACE face, int level, C3D_DEPTHTYPE depthFmt)
 {
 	if (!addrIsVRAM(tex->data)) return NULL; // Render targets must be in VRAM
@@ -346,6 +1130,15 @@ C3D_RenderTarget* C3D_RenderTargetCreateFromTex(C3D_Tex* tex, GPU_TEXFACE face,
 
 void C3Di_RenderTargetDestroy(C3D_RenderTarget* target)
 {
+	if (target->dynamicRes)
+	{
+		target->frameBuf.colorBuf = target->resColorBuf;
+		if (target->resTex)
+		{
+			C3D_TexDelete(target->resTex);
+			free(target->resTex);
+		}
+	}
 	if (target->ownsColor)
 		vramFree(target->frameBuf.colorBuf);
 	if (target->ownsDepth)
@@ -369,6 +1162,216 @@ void C3D_RenderTargetDelete(C3D_RenderTarget* target)
 	C3Di_RenderTargetDestroy(target);
 }
 
+void C3D_RenderTargetDeleteDeferred(C3D_RenderTarget* target)
+{
+	int i;
+	for (i = 0; i < 3; i ++)
+		if (linkedTarget[i] == target)
+			linkedTarget[i] = NULL;
+	target->linked = false;
+	target->used = false;
+	C3Di_DeferredRenderTarget(target);
+}
+
+bool C3D_RenderTargetDepthAlternate(C3D_RenderTarget* target, bool enable)
+{
+	if (enable && target->frameBuf.depthBuf && target->frameBuf.depthFmt == GPU_RB_DEPTH24_STENCIL8)
+		return false;
+
+	target->depthAlternate = enable;
+	target->depthValid = false;
+	target->depthDrawn = false;
+	target->depthPhase = 0;
+	return true;
+}
+
+// Returns the buffers that really need a clear, switching halves instead of clearing depth
+static C3D_ClearBits C3Di_DepthAlternateClear(C3D_RenderTarget* target, C3D_ClearBits clearBits)
+{
+	if (!target->depthAlternate || !(clearBits & C3D_CLEAR_DEPTH))
+		return clearBits;
+
+	if (!target->depthValid)
+	{
+		// The first clear is real, and the direct half starts
+		target->depthValid = true;
+		target->depthPhase = 0;
+	} else
+	{
+		// Keep the phase if nothing was drawn: the buffer still holds the older half
+		if (target->depthDrawn)
+			target->depthPhase ^= 1;
+		clearBits &= ~C3D_CLEAR_DEPTH;
+	}
+	target->depthDrawn = false;
+
+	// The target may stay bound without another C3D_FrameDrawOn
+	C3D_Context* ctx = C3Di_GetContext();
+	if (target->frameBuf.depthBuf && ctx->fb.depthBuf == target->frameBuf.depthBuf && ctx->depthPhase != 1+target->depthPhase)
+	{
+		ctx->depthPhase = 1+target->depthPhase;
+		ctx->flags |= C3DiF_Effect;
+	}
+	return clearBits;
+}
+
+void C3D_RenderTargetClear(C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	clearBits = C3Di_DepthAlternateClear(target, clearBits);
+	if (!clearBits)
+		return;
+	if (!target->trackDirty)
+		C3D_FrameBufClear(&target->frameBuf, clearBits, clearColor, clearDepth);
+	else if (C3D_RenderTargetIsDirty(target))
+		C3Di_FrameBufClearRows(&target->frameBuf, clearBits, clearColor, clearDepth, target->dirtyY0, target->dirtyY1);
+}
+
+void C3D_SetClearQuadFunc(C3D_ClearQuadFunc func, void* param)
+{
+	clearQuadFunc = func;
+	clearQuadParam = param;
+}
+
+void C3D_SetUpscaleFunc(C3D_UpscaleFunc func, void* param)
+{
+	upscaleFunc = func;
+	upscaleParam = param;
+}
+
+static void C3Di_ClearQuad(C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u32 x0, u32 y0, u32 x1, u32 y1)
+{
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	C3D_SetScissor(GPU_SCISSOR_NORMAL, x0, y0, x1, y1);
+	clearQuadFunc(clearBits, clearColor, clearDepth, clearQuadParam);
+}
+
+bool C3D_RenderTargetClearRect(C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, u16 x, u16 y, u16 w, u16 h)
+{
+	C3D_FrameBuf* fb = &target->frameBuf;
+	u32 tile = C3Di_FrameBufTileSize(fb);
+	u32 x1 = (u32)x + w, y1 = (u32)y + h;
+	if (x1 > fb->width)  x1 = fb->width;
+	if (y1 > fb->height) y1 = fb->height;
+	if (x >= x1 || y >= y1)
+		return true;
+
+	// Depth is not filled again once alternating, so a partial depth clear has no meaning
+	if (target->depthAlternate && (clearBits & C3D_CLEAR_DEPTH))
+		return false;
+
+	// Aligned interior, the edges of the buffer counting as aligned. Tile rows are
+	// counted from the bottom of the window, as the framebuffer is stored bottom-up.
+	u32 ix0 = (x + tile-1) &~ (tile-1);
+	u32 ix1 = x1 == fb->width ? x1 : x1 &~ (tile-1);
+	u32 iy0 = y == 0 ? 0 : fb->height - ((fb->height - y) &~ (tile-1));
+	u32 iy1 = (fb->height - y1 + tile-1) &~ (tile-1);
+	iy1 = iy1 > fb->height ? 0 : fb->height - iy1;
+	bool aligned = ix0 == x && iy0 == y && ix1 == x1 && iy1 == y1;
+
+	if (!aligned && (!clearQuadFunc || !inFrame))
+		return false;
+
+	if (inFrame)
+		C3D_FrameSplit(0);
+
+	if (ix0 < ix1 && iy0 < iy1)
+		C3D_FrameBufClearRect(fb, clearBits, clearColor, clearDepth, ix0, iy0, ix1-ix0, iy1-iy0);
+	else
+		ix0 = ix1 = x1, iy0 = iy1 = y1; // No interior: the top strip covers everything
+
+	if (aligned)
+		return true;
+
+	// The quads are drawn on the target, then whatever was bound before is restored
+	C3D_Context* ctx = C3Di_GetContext();
+	C3D_FrameBuf boundFb = ctx->fb;
+	u32 viewport[5], scissor[3];
+	u8 depthPhase = ctx->depthPhase;
+	memcpy(viewport, ctx->viewport, sizeof(viewport));
+	memcpy(scissor, ctx->scissor, sizeof(scissor));
+	C3D_FrameDrawOn(target);
+
+	C3Di_ClearQuad(clearBits, clearColor, clearDepth, x,   y,   x1,  iy0); // Top
+	C3Di_ClearQuad(clearBits, clearColor, clearDepth, x,   iy1, x1,  y1);  // Bottom
+	C3Di_ClearQuad(clearBits, clearColor, clearDepth, x,   iy0, ix0, iy1); // Left
+	C3Di_ClearQuad(clearBits, clearColor, clearDepth, ix1, iy0, x1,  iy1); // Right
+
+	if (boundFb.colorBuf || boundFb.depthBuf)
+		C3D_SetFrameBuf(&boundFb);
+	memcpy(ctx->viewport, viewport, sizeof(viewport));
+	memcpy(ctx->scissor, scissor, sizeof(scissor));
+	if (ctx->depthPhase != depthPhase)
+	{
+		ctx->depthPhase = depthPhase;
+		ctx->flags |= C3DiF_Effect;
+	}
+	ctx->flags |= C3DiF_Viewport | C3DiF_Scissor;
+	return true;
+}
+
+void C3D_ClearTargets(C3D_RenderTarget* const targets[], int count, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	int i, n;
+	C3Di_FillSpan spans[2];
+	C3Di_FillBatch batch = { .havePending = false };
+
+	// Each buffer is paired with the previous leftover one, possibly from another target
+	for (i = 0; i < count; i ++)
+	{
+		C3D_RenderTarget* target = targets[i];
+		if (!target)
+			continue;
+
+		C3D_ClearBits bits = C3Di_DepthAlternateClear(target, clearBits);
+		if (!target->trackDirty)
+			n = C3Di_FrameBufClearSpans(&target->frameBuf, bits, clearColor, clearDepth, 0, target->frameBuf.height, spans);
+		else if (C3D_RenderTargetIsDirty(target))
+			n = C3Di_FrameBufClearSpans(&target->frameBuf, bits, clearColor, clearDepth, target->dirtyY0, target->dirtyY1, spans);
+		else
+			continue;
+		C3Di_FillPush(&batch, spans, n);
+	}
+
+	C3Di_FillFlush(&batch);
+}
+
+void C3D_RenderTargetTrackDirty(C3D_RenderTarget* target, bool enable)
+{
+	target->trackDirty = enable;
+	target->dirtyY0 = 0;
+	target->dirtyY1 = enable ? target->frameBuf.height : 0;
+}
+
+void C3D_RenderTargetMarkDirty(C3D_RenderTarget* target, u16 y, u16 h)
+{
+	if (!target->trackDirty || !h || y >= target->frameBuf.height)
+		return;
+
+	// Widen to whole tile rows, which are counted from the bottom of the window
+	u32 height = target->frameBuf.height;
+	u32 tile = C3Di_FrameBufTileSize(&target->frameBuf);
+	u32 y1 = (u32)y + h;
+	if (y1 > height)
+		y1 = height;
+	u32 s0 = (height - y1) &~ (tile-1);
+	u32 s1 = (height - y + tile-1) &~ (tile-1);
+	if (s1 > height)
+		s1 = height;
+	u16 y0 = height - s1;
+	y1 = height - s0;
+	if (!C3D_RenderTargetIsDirty(target))
+	{
+		target->dirtyY0 = y0;
+		target->dirtyY1 = y1;
+		return;
+	}
+	if (y0 < target->dirtyY0)
+		target->dirtyY0 = y0;
+	if (y1 > target->dirtyY1)
+		target->dirtyY1 = y1;
+}
+
 void C3D_RenderTargetSetOutput(C3D_RenderTarget* target, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags)
 {
 	int id = 0;
@@ -419,7 +1422,7 @@ void C3D_SyncDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32
 	if (inFrame)
 	{
 		C3D_FrameSplit(0);
-		GX_DisplayTransfer(inadr, indim, outadr, outdim, flags);
+		C3Di_QueueDisplayTransfer(inadr, indim, outadr, outdim, flags);
 	} else
 	{
 		C3Di_SafeDisplayTransfer(inadr, indim, outadr, outdim, flags);
@@ -432,7 +1435,7 @@ void C3D_SyncTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 siz
 	if (inFrame)
 	{
 		C3D_FrameSplit(0);
-		GX_TextureCopy(inadr, indim, outadr, outdim, size, flags);
+		C3Di_QueueTextureCopy(inadr, indim, outadr, outdim, size, flags);
 	} else
 	{
 		C3Di_SafeTextureCopy(inadr, indim, outadr, outdim, size, flags);
@@ -445,10 +1448,53 @@ void C3D_SyncMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* bu
 	if (inFrame)
 	{
 		C3D_FrameSplit(0);
-		GX_MemoryFill(buf0a, buf0v, buf0e, control0, buf1a, buf1v, buf1e, control1);
+		C3Di_QueueMemoryFill(buf0a, buf0v, buf0e, control0, buf1a, buf1v, buf1e, control1);
 	} else
 	{
 		C3Di_SafeMemoryFill(buf0a, buf0v, buf0e, control0, buf1a, buf1v, buf1e, control1);
 		gspWaitForPSC0();
 	}
 }
+
+static void C3Di_AsyncBegin(void)
+{
+	gxCmdQueue_s* queue = &C3Di_GetContext()->gxQueue;
+	if (inFrame)
+	{
+		C3D_FrameSplit(0);
+		return;
+	}
+
+	// Outside a frame, recycle the queue once idle. Never append to the last frame's
+	// work, whose completion swaps the buffers and ends its GPU time measurement
+	if (measureGpuTime || queue->lastEntry == queue->numEntries)
+		C3Di_WaitAndClearQueue(-1);
+}
+
+static C3D_Fence C3Di_AsyncEnd(void)
+{
+	if (!inFrame)
+		gxCmdQueueRun(&C3Di_GetContext()->gxQueue);
+	return C3D_FenceInsert();
+}
+
+C3D_Fence C3D_AsyncDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags)
+{
+	C3Di_AsyncBegin();
+	C3Di_QueueDisplayTransfer(inadr, indim, outadr, outdim, flags);
+	return C3Di_AsyncEnd();
+}
+
+C3D_Fence C3D_AsyncTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags)
+{
+	C3Di_AsyncBegin();
+	C3Di_QueueTextureCopy(inadr, indim, outadr, outdim, size, flags);
+	return C3Di_AsyncEnd();
+}
+
+C3D_Fence C3D_AsyncMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* buf1a, u32 buf1v, u32* buf1e, u16 control1)
+{
+	C3Di_AsyncBegin();
+	C3Di_QueueMemoryFill(buf0a, buf0v, buf0e, control0, buf1a, buf1v, buf1e, control1);
+	return C3Di_AsyncEnd();
+}
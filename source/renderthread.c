@@ -0,0 +1,99 @@
+#include "internal.h"
+#include <c3d/renderthread.h>
+#include <stdlib.h>
+
+static void C3Di_RenderThreadMain(void* arg)
+{
+	C3D_RenderThread* rt = (C3D_RenderThread*)arg;
+	for (;;)
+	{
+		// Read quit before draining, so packets committed before C3D_RenderThreadStop are replayed
+		bool quit = __atomic_load_n(&rt->quit, __ATOMIC_ACQUIRE);
+		const void* data;
+		u16 op;
+		int count = 0;
+
+		while ((data = C3D_PacketPeek(&rt->queue, &op, NULL)))
+		{
+			C3Di_RecReplay(op, data);
+			C3D_PacketPop(&rt->queue);
+
+			// Let a stalled game thread resume before the whole queue is drained
+			if (++count == 64)
+			{
+				LightEvent_Signal(&rt->space);
+				count = 0;
+			}
+		}
+		LightEvent_Signal(&rt->space);
+
+		if (quit)
+			break;
+		LightEvent_Wait(&rt->wake);
+	}
+}
+
+static void* C3Di_RenderThreadBegin(C3D_Recorder* rec, u16 op, size_t size)
+{
+	C3D_RenderThread* rt = (C3D_RenderThread*)rec;
+	void* p;
+	while (!(p = C3D_PacketBegin(&rt->queue, op, size)))
+	{
+		if (size > rt->queue.size/4 - sizeof(C3D_PacketHeader))
+			return NULL; // Never fits
+		rt->stalls++;
+		LightEvent_Wait(&rt->space);
+	}
+	return p;
+}
+
+static void C3Di_RenderThreadCommit(C3D_Recorder* rec)
+{
+	C3D_RenderThread* rt = (C3D_RenderThread*)rec;
+	C3D_PacketCommit(&rt->queue);
+	LightEvent_Signal(&rt->wake);
+}
+
+bool C3D_RenderThreadStart(C3D_RenderThread* rt, u32 queueSize, int prio, int core)
+{
+	memset(rt, 0, sizeof(*rt));
+	rt->rec.begin = C3Di_RenderThreadBegin;
+	rt->rec.commit = C3Di_RenderThreadCommit;
+	rt->buf = malloc(queueSize);
+	if (!rt->buf)
+		return false;
+	if (!C3D_PacketQueueInit(&rt->queue, rt->buf, queueSize))
+		goto _fail;
+
+	LightEvent_Init(&rt->wake, RESET_ONESHOT);
+	LightEvent_Init(&rt->space, RESET_ONESHOT);
+	rt->thread = threadCreate(C3Di_RenderThreadMain, rt, 32*1024, prio, core, false);
+	if (!rt->thread)
+		goto _fail;
+	return true;
+
+_fail:
+	free(rt->buf);
+	rt->buf = NULL;
+	return false;
+}
+
+void C3D_RenderThreadStop(C3D_RenderThread* rt)
+{
+	if (!rt->thread)
+		return;
+
+	__atomic_store_n(&rt->quit, true, __ATOMIC_RELEASE);
+	LightEvent_Signal(&rt->wake);
+	threadJoin(rt->thread, U64_MAX);
+	threadFree(rt->thread);
+	rt->thread = NULL;
+	free(rt->buf);
+	rt->buf = NULL;
+}
+
+void C3D_RenderThreadSync(C3D_RenderThread* rt)
+{
+	while (!C3D_PacketQueueEmpty(&rt->queue))
+		LightEvent_Wait(&rt->space);
+}
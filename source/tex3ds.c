@@ -24,6 +24,7 @@
  *  @brief Tex3DS routines
  */
 #include <tex3ds.h>
+#include <c3d/base.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -180,6 +181,8 @@ Tex3DSi_ImportCommon(C3D_Tex* tex, C3D_TexCube* texcube, bool vram, decompressCa
 			free(texture);
 			return NULL;
 		}
+		for (size_t i = 0; i < 6; ++i)
+			C3D_FlushRange(iov[i].data, iov[i].size);
 	} else
 	{
 		u32 size;
@@ -192,6 +195,7 @@ Tex3DSi_ImportCommon(C3D_Tex* tex, C3D_TexCube* texcube, bool vram, decompressCa
 			free(texture);
 			return NULL;
 		}
+		C3D_FlushRange(data, size);
 	}
 
 	return texture;
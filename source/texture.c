@@ -1,4 +1,5 @@
 #include "internal.h"
+#include <c3d/base.h>
 #include <c3d/renderqueue.h>
 
 // Return bits per pixel
@@ -39,14 +40,6 @@ static inline bool checkTexSize(u32 size)
 	return true;
 }
 
-static inline void allocFree(void* addr)
-{
-	if (addrIsVRAM(addr))
-		vramFree(addr);
-	else
-		linearFree(addr);
-}
-
 static void C3Di_TexCubeDelete(C3D_TexCube* cube)
 {
 	int i;
@@ -60,16 +53,42 @@ static void C3Di_TexCubeDelete(C3D_TexCube* cube)
 	}
 }
 
-bool C3D_TexInitWithParams(C3D_Tex* tex, C3D_TexCube* cube, C3D_TexInitParams p)
+u32 C3Di_TexInitSize(C3D_TexInitParams p)
 {
-	if (!checkTexSize(p.width) || !checkTexSize(p.height)) return false;
+	if (!checkTexSize(p.width) || !checkTexSize(p.height)) return 0;
+	return fmtSize(p.format) * p.width * p.height / 8;
+}
 
+static void C3Di_TexInitCommon(C3D_Tex* tex, C3D_TexInitParams p, u32 size)
+{
+	tex->width = p.width;
+	tex->height = p.height;
+	tex->param = GPU_TEXTURE_MODE(p.type);
+	if (p.format == GPU_ETC1)
+		tex->param |= GPU_TEXTURE_ETC1_PARAM;
+	if (p.type == GPU_TEX_SHADOW_2D || p.type == GPU_TEX_SHADOW_CUBE)
+		tex->param |= GPU_TEXTURE_SHADOW_PARAM;
+	tex->fmt = p.format;
+	tex->size = size;
+	tex->border = 0;
+	tex->lodBias = 0;
+	tex->maxLevel = p.maxLevel;
+	tex->minLevel = 0;
+}
+
+void C3Di_TexInitWithMem(C3D_Tex* tex, C3D_TexInitParams p, void* data)
+{
+	tex->data = data;
+	C3Di_TexInitCommon(tex, p, C3Di_TexInitSize(p));
+}
+
+bool C3D_TexInitWithParams(C3D_Tex* tex, C3D_TexCube* cube, C3D_TexInitParams p)
+{
 	bool isCube = typeIsCube(p.type);
 	if (isCube && !cube) return false;
 
-	u32 size = fmtSize(p.format);
+	u32 size = C3Di_TexInitSize(p);
 	if (!size) return false;
-	size *= (u32)p.width * p.height / 8;
 	u32 total_size = C3D_TexCalcTotalSize(size, p.maxLevel);
 
 	if (!isCube)
@@ -93,19 +112,7 @@ bool C3D_TexInitWithParams(C3D_Tex* tex, C3D_TexCube* cube, C3D_TexInitParams p)
 		tex->cube = cube;
 	}
 
-	tex->width = p.width;
-	tex->height = p.height;
-	tex->param = GPU_TEXTURE_MODE(p.type);
-	if (p.format == GPU_ETC1)
-		tex->param |= GPU_TEXTURE_ETC1_PARAM;
-	if (p.type == GPU_TEX_SHADOW_2D || p.type == GPU_TEX_SHADOW_CUBE)
-		tex->param |= GPU_TEXTURE_SHADOW_PARAM;
-	tex->fmt = p.format;
-	tex->size = size;
-	tex->border = 0;
-	tex->lodBias = 0;
-	tex->maxLevel = p.maxLevel;
-	tex->minLevel = 0;
+	C3Di_TexInitCommon(tex, p, size);
 	return true;
 }
 
@@ -117,11 +124,31 @@ void C3D_TexLoadImage(C3D_Tex* tex, const void* data, GPU_TEXFACE face, int leve
 		level, &size);
 
 	if (!addrIsVRAM(out))
+	{
 		memcpy(out, data, size);
-	else
+		C3D_FlushRange(out, size);
+	} else
 		C3D_SyncTextureCopy((u32*)data, 0, (u32*)out, 0, size, 8);
 }
 
+C3D_Fence C3D_TexLoadImageAsync(C3D_Tex* tex, const void* data, GPU_TEXFACE face, int level)
+{
+	u32 size = 0;
+	void* out = C3D_TexGetImagePtr(tex,
+		C3Di_TexIs2D(tex) ? tex->data : tex->cube->data[face],
+		level, &size);
+
+	if (!addrIsVRAM(out))
+	{
+		memcpy(out, data, size);
+		C3D_FlushRange(out, size);
+		return C3D_FenceNone();
+	}
+
+	GSPGPU_FlushDataCache(data, size);
+	return C3D_AsyncTextureCopy((u32*)data, 0, (u32*)out, 0, size, 8);
+}
+
 static void C3Di_DownscaleRGBA8(u32* dst, const u32* src[4])
 {
 	u32 i, j;
@@ -212,6 +239,7 @@ void C3D_TexGenerateMipmap(C3D_Tex* tex, GPU_TEXFACE face)
 			}
 		}
 
+		C3D_FlushRange(dst, level_size >> 2);
 		level_size >>= 2;
 		src = dst;
 		src_width = dst_width;
@@ -247,6 +275,26 @@ void C3D_TexDelete(C3D_Tex* tex)
 		C3Di_TexCubeDelete(tex->cube);
 }
 
+void C3D_TexDeleteDeferred(C3D_Tex* tex)
+{
+	int i;
+	if (C3Di_TexIs2D(tex))
+	{
+		C3D_FreeDeferred(tex->data);
+		tex->data = NULL;
+		return;
+	}
+
+	for (i = 0; i < 6; i ++)
+	{
+		if (tex->cube->data[i])
+		{
+			C3D_FreeDeferred(tex->cube->data[i]);
+			tex->cube->data[i] = NULL;
+		}
+	}
+}
+
 void C3D_TexShadowParams(bool perspective, float bias)
 {
 	C3D_Context* ctx = C3Di_GetContext();
@@ -19,6 +19,103 @@ static struct
 static bool C3Di_FVUnifEverDirty[2][C3D_FVUNIF_COUNT];
 static bool C3Di_IVUnifEverDirty[2][C3D_IVUNIF_COUNT];
 
+static struct
+{
+	C3D_FVUnifLatchFunc func;
+	void* param;
+	u8 type, id, size;
+} C3Di_FVUnifLatch[C3D_FVUNIF_LATCH_COUNT];
+
+#define C3Di_FVUNIF_PATCH_COUNT 64
+
+// Recorded uploads of latched ranges in the current command list
+static struct
+{
+	u32* words;
+	u8 latch;
+} C3Di_FVUnifPatch[C3Di_FVUNIF_PATCH_COUNT];
+static int C3Di_FVUnifPatchCount;
+
+bool C3D_FVUnifLateLatch(GPU_SHADER_TYPE type, int id, int size, C3D_FVUnifLatchFunc func, void* param)
+{
+	int i, slot = -1;
+	if (id < 0 || size <= 0 || id+size > C3D_FVUNIF_COUNT)
+		return false;
+
+	for (i = 0; i < C3D_FVUNIF_LATCH_COUNT; i ++)
+	{
+		if (C3Di_FVUnifLatch[i].func && C3Di_FVUnifLatch[i].type == type && C3Di_FVUnifLatch[i].id == id)
+		{
+			slot = i;
+			break;
+		}
+		if (!C3Di_FVUnifLatch[i].func && slot < 0)
+			slot = i;
+	}
+
+	if (slot < 0)
+		return !func;
+
+	// Only the first latch covering a register is ever patched, so ranges must not overlap
+	for (i = 0; func && i < C3D_FVUNIF_LATCH_COUNT; i ++)
+	{
+		if (i == slot || !C3Di_FVUnifLatch[i].func || C3Di_FVUnifLatch[i].type != type)
+			continue;
+		if (id < C3Di_FVUnifLatch[i].id+C3Di_FVUnifLatch[i].size && C3Di_FVUnifLatch[i].id < id+size)
+			return false;
+	}
+
+	C3Di_FVUnifLatch[slot].func  = func;
+	C3Di_FVUnifLatch[slot].param = param;
+	C3Di_FVUnifLatch[slot].type  = type;
+	C3Di_FVUnifLatch[slot].id    = id;
+	C3Di_FVUnifLatch[slot].size  = size;
+	return true;
+}
+
+static int C3Di_FVUnifLatchAt(GPU_SHADER_TYPE type, int id)
+{
+	int i;
+	for (i = 0; i < C3D_FVUNIF_LATCH_COUNT; i ++)
+	{
+		if (!C3Di_FVUnifLatch[i].func || C3Di_FVUnifLatch[i].type != type)
+			continue;
+		if (id >= C3Di_FVUnifLatch[i].id && id < C3Di_FVUnifLatch[i].id+C3Di_FVUnifLatch[i].size)
+			return i;
+	}
+	return -1;
+}
+
+// Address of a data word written through GPUCMD_Add: [param0][header][param1...]
+static inline u32* C3Di_PatchWord(u32* words, int k)
+{
+	return k ? &words[k+1] : words;
+}
+
+void C3Di_ApplyUniformLatches(void)
+{
+	int i, k;
+	C3D_FVec data[C3D_FVUNIF_COUNT];
+
+	for (i = 0; i < C3Di_FVUnifPatchCount; i ++)
+	{
+		u32* words = C3Di_FVUnifPatch[i].words;
+		int latch = C3Di_FVUnifPatch[i].latch;
+		int size = C3Di_FVUnifLatch[latch].size;
+		if (!C3Di_FVUnifLatch[latch].func)
+			continue;
+
+		u32* raw = (u32*)data;
+		for (k = 0; k < size*4; k ++)
+			raw[k] = *C3Di_PatchWord(words, k);
+		C3Di_FVUnifLatch[latch].func(data, size, C3Di_FVUnifLatch[latch].param);
+		for (k = 0; k < size*4; k ++)
+			*C3Di_PatchWord(words, k) = raw[k];
+	}
+
+	C3Di_FVUnifPatchCount = 0;
+}
+
 void C3D_UpdateUniforms(GPU_SHADER_TYPE type)
 {
 	int offset = type == GPU_GEOMETRY_SHADER ? (GPUREG_GSH_BOOLUNIFORM-GPUREG_VSH_BOOLUNIFORM) : 0;
@@ -37,6 +134,19 @@ void C3D_UpdateUniforms(GPU_SHADER_TYPE type)
 		i = 0;
 	}
 
+	// Latched ranges are always uploaded whole so their words can be patched
+	for (i = 0; i < C3D_FVUNIF_LATCH_COUNT; i ++)
+	{
+		int k, id = C3Di_FVUnifLatch[i].id, size = C3Di_FVUnifLatch[i].size;
+		if (!C3Di_FVUnifLatch[i].func || C3Di_FVUnifLatch[i].type != type)
+			continue;
+		for (k = 0; k < size && !C3D_FVUnifDirty[type][id+k]; k ++);
+		if (k < size)
+			for (k = 0; k < size; k ++)
+				C3D_FVUnifDirty[type][id+k] = true;
+	}
+	i = 0;
+
 	// Update FVec uniforms
 	while (i < C3D_FVUNIF_COUNT)
 	{
@@ -46,14 +156,30 @@ void C3D_UpdateUniforms(GPU_SHADER_TYPE type)
 			continue;
 		}
 
-		// Find the number of consecutive dirty uniforms
-		int j;
-		for (j = i; j < C3D_FVUNIF_COUNT && C3D_FVUnifDirty[type][j]; j ++);
+		// Find the number of consecutive dirty uniforms, splitting at latched ranges
+		int j, latch = C3Di_FVUnifLatchAt(type, i);
+		if (latch >= 0)
+			j = C3Di_FVUnifLatch[latch].id + C3Di_FVUnifLatch[latch].size;
+		else
+			for (j = i; j < C3D_FVUNIF_COUNT && C3D_FVUnifDirty[type][j] && C3Di_FVUnifLatchAt(type, j) < 0; j ++);
+
+		// Submit what was recorded so far if this upload can't be patched otherwise
+		if (latch >= 0 && C3Di_FVUnifPatchCount == C3Di_FVUNIF_PATCH_COUNT)
+			C3D_FrameSplit(0);
 
 		// Upload the uniforms
 		GPUCMD_AddWrite(GPUREG_VSH_FLOATUNIFORM_CONFIG+offset, 0x80000000|i);
+		u32* words = gpuCmdBuf + gpuCmdBufOffset;
+		u32 start = gpuCmdBufOffset;
 		GPUCMD_AddWrites(GPUREG_VSH_FLOATUNIFORM_DATA+offset, (u32*)&C3D_FVUnif[type][i], (j-i)*4);
 
+		// Record where the latched words ended up
+		if (latch >= 0 && gpuCmdBufOffset != start && C3Di_FVUnifPatchCount < C3Di_FVUNIF_PATCH_COUNT)
+		{
+			C3Di_FVUnifPatch[C3Di_FVUnifPatchCount].words = words;
+			C3Di_FVUnifPatch[C3Di_FVUnifPatchCount++].latch = latch;
+		}
+
 		// Clear the dirty flag
 		int k;
 		for (k = i; k < j; k ++)
@@ -0,0 +1,230 @@
+#include "internal.h"
+#include <c3d/vramplan.h>
+
+#define C3Di_VRAM_BANK_SIZE (OS_VRAM_SIZE/2)
+#define C3Di_VRAM_ALIGN     0x80 // Allocation granularity used when probing
+#define C3Di_VRAM_MAX_PROBE 16
+
+static int C3Di_VramPlanAdd(C3D_VramPlan* plan, u8 kind, u32 size, u32 groups)
+{
+	if (plan->numItems == C3D_VRAMPLAN_MAX_ITEMS || !size)
+		return -1;
+
+	C3D_VramItem* item = &plan->items[plan->numItems];
+	memset(item, 0, sizeof(*item));
+	item->kind = kind;
+	item->size = size;
+	item->groups = groups;
+	item->depth = -1;
+	return plan->numItems++;
+}
+
+void C3D_VramPlanInit(C3D_VramPlan* plan)
+{
+	plan->numItems = 0;
+	plan->conflictBytes = 0;
+}
+
+int C3D_VramPlanTarget(C3D_VramPlan* plan, u16 width, u16 height, GPU_COLORBUF colorFmt, C3D_DEPTHTYPE depthFmt, u32 groups)
+{
+	bool hasDepth = C3D_DEPTHTYPE_OK(depthFmt);
+	if (plan->numItems + (hasDepth ? 2 : 1) > C3D_VRAMPLAN_MAX_ITEMS)
+		return -1;
+
+	int id = C3Di_VramPlanAdd(plan, C3D_VRAM_COLOR, C3D_CalcColorBufSize(width, height, colorFmt), groups);
+	if (id < 0)
+		return -1;
+
+	C3D_VramItem* item = &plan->items[id];
+	item->rt.width = width;
+	item->rt.height = height;
+	item->rt.colorFmt = colorFmt;
+	if (hasDepth)
+	{
+		item->rt.depthFmt = C3D_DEPTHTYPE_VAL(depthFmt);
+		item->depth = C3Di_VramPlanAdd(plan, C3D_VRAM_DEPTH, C3D_CalcDepthBufSize(width, height, item->rt.depthFmt), groups);
+	}
+	return id;
+}
+
+int C3D_VramPlanTex(C3D_VramPlan* plan, C3D_Tex* tex, C3D_TexInitParams params, u32 groups)
+{
+	if (typeIsCube(params.type))
+		return -1;
+
+	u32 size = C3Di_TexInitSize(params);
+	int id = C3Di_VramPlanAdd(plan, C3D_VRAM_TEX, size ? C3D_TexCalcTotalSize(size, params.maxLevel) : 0, groups);
+	if (id < 0)
+		return -1;
+
+	plan->items[id].tex.tex = tex;
+	plan->items[id].tex.params = params;
+	return id;
+}
+
+static bool C3Di_VramConflict(const C3D_VramPlan* plan, int i, int j)
+{
+	const C3D_VramItem* a = &plan->items[i];
+	const C3D_VramItem* b = &plan->items[j];
+	return (a->groups & b->groups) || a->depth == j || b->depth == i;
+}
+
+static u32 C3Di_VramLargest(vramAllocPos bank)
+{
+	// Binary search on the size of the largest block the allocator can hand out
+	u32 lo = 0, hi = C3Di_VRAM_BANK_SIZE / C3Di_VRAM_ALIGN;
+	while (lo < hi)
+	{
+		u32 mid = (lo + hi + 1) / 2;
+		void* mem = vramAllocAt(mid*C3Di_VRAM_ALIGN, bank);
+		if (mem)
+		{
+			vramFree(mem);
+			lo = mid;
+		} else
+			hi = mid - 1;
+	}
+	return lo*C3Di_VRAM_ALIGN;
+}
+
+void C3D_VramGetStats(C3D_VramStats* stats)
+{
+	int b, i;
+	void* probes[C3Di_VRAM_MAX_PROBE];
+	memset(stats, 0, sizeof(*stats));
+
+	for (b = 0; b < 2; b ++)
+	{
+		vramAllocPos bank = b ? VRAM_ALLOC_B : VRAM_ALLOC_A;
+		int n = 0;
+
+		// Take the free blocks away one at a time, largest first
+		while (n < C3Di_VRAM_MAX_PROBE)
+		{
+			u32 size = C3Di_VramLargest(bank);
+			if (!size || !(probes[n] = vramAllocAt(size, bank)))
+				break;
+			if (!n)
+				stats->largest[b] = size;
+			stats->free[b] += size;
+			n++;
+		}
+
+		for (i = 0; i < n; i ++)
+			vramFree(probes[i]);
+
+		stats->blocks[b] = n;
+		stats->fragmentation[b] = stats->free[b] ? 1.0f - (float)stats->largest[b] / stats->free[b] : 0.0f;
+	}
+}
+
+static void C3Di_VramPlanFree(C3D_VramPlan* plan)
+{
+	int i;
+	for (i = 0; i < plan->numItems; i ++)
+	{
+		if (plan->items[i].mem)
+			vramFree(plan->items[i].mem);
+		plan->items[i].mem = NULL;
+	}
+}
+
+bool C3D_VramPlanCommit(C3D_VramPlan* plan)
+{
+	int i, j, b, n = plan->numItems;
+	u8 order[C3D_VRAMPLAN_MAX_ITEMS];
+	C3D_VramStats stats;
+	s32 room[2];
+
+	// Largest first
+	for (i = 0; i < n; i ++)
+	{
+		for (j = i; j > 0 && plan->items[order[j-1]].size < plan->items[i].size; j --)
+			order[j] = order[j-1];
+		order[j] = i;
+	}
+
+	C3D_VramGetStats(&stats);
+	room[0] = stats.free[0];
+	room[1] = stats.free[1];
+
+	for (i = 0; i < n; i ++)
+	{
+		C3D_VramItem* item = &plan->items[order[i]];
+		u32 cost[2] = { 0, 0 };
+
+		for (j = 0; j < i; j ++)
+			if (C3Di_VramConflict(plan, order[i], order[j]))
+				cost[plan->items[order[j]].bank == VRAM_ALLOC_B] += plan->items[order[j]].size;
+
+		bool fits0 = room[0] >= (s32)item->size, fits1 = room[1] >= (s32)item->size;
+		if (fits0 != fits1)
+			b = fits1;
+		else if (cost[0] != cost[1])
+			b = cost[1] < cost[0];
+		else
+			b = room[1] > room[0];
+
+		item->bank = b ? VRAM_ALLOC_B : VRAM_ALLOC_A;
+		room[b] -= item->size;
+	}
+
+	for (i = 0; i < n; i ++)
+	{
+		C3D_VramItem* item = &plan->items[order[i]];
+		item->mem = vramAllocAt(item->size, (vramAllocPos)item->bank);
+		if (!item->mem)
+			item->mem = vramAllocAt(item->size, (vramAllocPos)(item->bank ^ VRAM_ALLOC_ANY));
+		if (!item->mem)
+		{
+			C3Di_VramPlanFree(plan);
+			return false;
+		}
+		item->bank = addrGetVRAMBank(item->mem);
+	}
+
+	plan->conflictBytes = 0;
+	for (i = 0; i < n; i ++)
+		for (j = i+1; j < n; j ++)
+			if (plan->items[i].bank == plan->items[j].bank && C3Di_VramConflict(plan, i, j))
+				plan->conflictBytes += plan->items[i].size < plan->items[j].size ? plan->items[i].size : plan->items[j].size;
+
+	// Targets first: only they can fail, and no texture may point at memory freed by the rollback
+	for (i = 0; i < n; i ++)
+	{
+		C3D_VramItem* item = &plan->items[i];
+		if (item->kind == C3D_VRAM_COLOR)
+		{
+			C3D_VramItem* depth = item->depth >= 0 ? &plan->items[item->depth] : NULL;
+			item->rt.target = C3Di_RenderTargetFromBuffers(item->rt.width, item->rt.height,
+				item->mem, item->rt.colorFmt, depth ? depth->mem : NULL, item->rt.depthFmt);
+			if (!item->rt.target)
+			{
+				// Out of heap memory: undo the targets created so far
+				for (j = 0; j < i; j ++)
+					if (plan->items[j].kind == C3D_VRAM_COLOR)
+					{
+						C3D_RenderTargetDelete(plan->items[j].rt.target);
+						plan->items[j].rt.target = NULL;
+						plan->items[j].mem = NULL;
+						if (plan->items[j].depth >= 0)
+							plan->items[plan->items[j].depth].mem = NULL;
+					}
+				C3Di_VramPlanFree(plan);
+				return false;
+			}
+		}
+	}
+
+	for (i = 0; i < n; i ++)
+		if (plan->items[i].kind == C3D_VRAM_TEX)
+			C3Di_TexInitWithMem(plan->items[i].tex.tex, plan->items[i].tex.params, plan->items[i].mem);
+	return true;
+}
+
+C3D_RenderTarget* C3D_VramPlanGetTarget(const C3D_VramPlan* plan, int id)
+{
+	if (id < 0 || id >= plan->numItems || plan->items[id].kind != C3D_VRAM_COLOR)
+		return NULL;
+	return plan->items[id].rt.target;
+}
@@ -2,7 +2,9 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <random>
+#include <thread>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,7 +13,11 @@
 
 extern "C" {
 #include <c3d/maths.h>
+#include <c3d/lightlut.h>
+#include <c3d/foglut.h>
+#include <c3d/packetqueue.h>
 }
+#include <c3d/lutgen.h>
 
 typedef std::default_random_engine            generator_t;
 typedef std::uniform_real_distribution<float> distribution_t;
@@ -966,6 +972,221 @@ check_quaternion(generator_t &gen, distribution_t &dist)
   }
 }
 
+static constexpr float
+lutRamp(float x, float param)
+{
+  return x*x*param - 0.25f*x;
+}
+
+struct LutRamp
+{
+  float param;
+  constexpr float operator()(float x) const { return lutRamp(x, param); }
+};
+
+static void
+check_lutgen()
+{
+  using namespace C3D::LutGen;
+
+  // check light LUTs
+  {
+    static constexpr C3D_LightLut pos = LightLut(LutRamp{1.5f});
+    static constexpr C3D_LightLut neg = LightLut(LutRamp{1.5f}, true);
+    static constexpr C3D_LightLut spot = LightLut(SpotStep{0.75f}, true);
+    C3D_LightLut lut;
+
+    LightLut_FromFunc(&lut, lutRamp, 1.5f, false);
+    assert(std::memcmp(&lut, &pos, sizeof(lut)) == 0);
+
+    LightLut_FromFunc(&lut, lutRamp, 1.5f, true);
+    assert(std::memcmp(&lut, &neg, sizeof(lut)) == 0);
+
+    LightLut_FromFunc(&lut, spot_step, 0.75f, true);
+    assert(std::memcmp(&lut, &spot, sizeof(lut)) == 0);
+  }
+
+  // check distance attenuation LUT
+  {
+    static constexpr C3D_LightLutDA da = LightLutDA(QuadraticDistAttn{0.1f, 0.02f}, 0.5f, 20.0f);
+    C3D_LightLutDA lut;
+
+    LightLutDA_Quadratic(&lut, 0.5f, 20.0f, 0.1f, 0.02f);
+    assert(std::memcmp(&lut, &da, sizeof(lut)) == 0);
+  }
+
+  // check fog LUT
+  {
+    static constexpr C3D_FogLut fog = FogLut(LutRamp{-0.5f});
+    C3D_FogLut lut;
+    float data[256];
+
+    for (int i = 0; i <= 128; ++i)
+    {
+      float val = lutRamp(i/128.0f, -0.5f);
+      if (i < 128)
+        data[i] = val;
+      if (i > 0)
+        data[i+127] = val-data[i-1];
+    }
+
+    FogLut_FromArray(&lut, data);
+    assert(std::memcmp(&lut, &fog, sizeof(lut)) == 0);
+  }
+
+  // check procedural texture LUT against ProcTexLut_FromArray's quantization
+  {
+    static constexpr ProcTexLut proc = ProcTexLutFromFunc(LutRamp{2.5f});
+    float in[129];
+
+    for (int i = 0; i <= 128; ++i)
+    {
+      float val = lutRamp(i/128.0f, 2.5f);
+      in[i] = val < 0.0f ? 0.0f : val > 1.0f ? 1.0f : val;
+    }
+
+    for (int i = 0; i < 128; ++i)
+    {
+      u32 cur  = 0xFFF*in[i];
+      u32 next = 0xFFF*in[i+1];
+      assert(proc.data[i] == (cur | (((next-cur)&0xFFF) << 12)));
+    }
+  }
+}
+
+// Counts entries differing from the runtime build, checking the value field is at most a step off
+static unsigned
+lutMismatches(const u32 *a, const u32 *b, unsigned count, unsigned shift, u32 mask)
+{
+  unsigned mismatches = 0;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (a[i] == b[i])
+      continue;
+    long va = (a[i] >> shift) & mask, vb = (b[i] >> shift) & mask;
+    assert(std::labs(va - vb) <= 1);
+    ++mismatches;
+  }
+  return mismatches;
+}
+
+static void
+check_lutgen_builtins()
+{
+  using namespace C3D::LutGen;
+
+  // the stock functors fold math builtins at compile time; a last-bit disagreement with libm
+  // may move an entry by one step, which must stay rare
+  static constexpr C3D_LightLut phong = LightLut(Phong{20.0f});
+  static constexpr C3D_LightLut spot = LightLut(Spotlight(0.5f), true);
+  static constexpr C3D_FogLut fog = FogLut(FogExp{0.05f, 1.0f, 0.1f, 100.0f});
+  C3D_LightLut lut;
+  C3D_FogLut fogLut;
+  unsigned mismatches = 0;
+
+  LightLut_Phong(&lut, 20.0f);
+  mismatches += lutMismatches(lut.data, phong.data, 256, 0, 0xFFF);
+
+  LightLut_Spotlight(&lut, 0.5f);
+  mismatches += lutMismatches(lut.data, spot.data, 256, 0, 0xFFF);
+
+  FogLut_Exp(&fogLut, 0.05f, 1.0f, 0.1f, 100.0f);
+  mismatches += lutMismatches(fogLut.data, fog.data, 128, 13, 0x7FF);
+
+  assert(mismatches <= (256 + 256 + 128) / 100);
+}
+
+static float
+lutSmooth(float x, float param)
+{
+  return C3D_LutShapeEval(C3D_LUT_SMOOTHSTEP, x, -0.3f, param);
+}
+
+static void
+check_lutshape()
+{
+  // check shape builders against the function pointer builders
+  {
+    C3D_LightLut ref, lut;
+
+    LightLut_Phong(&ref, 12.0f);
+    LightLut_FromShape(&lut, C3D_LUT_POW, 12.0f, 0.0f, false);
+    assert(std::memcmp(&lut, &ref, sizeof(lut)) == 0);
+
+    LightLut_FromFunc(&ref, lutSmooth, 0.6f, true);
+    LightLut_FromShape(&lut, C3D_LUT_SMOOTHSTEP, -0.3f, 0.6f, true);
+    assert(std::memcmp(&lut, &ref, sizeof(lut)) == 0);
+
+    // partial rebuild across the two's complement wrap
+    std::memset(&lut, 0, sizeof(lut));
+    LightLut_FromShapeRange(&lut, C3D_LUT_SMOOTHSTEP, -0.3f, 0.6f, true, 100, 60);
+    assert(std::memcmp(&lut.data[100], &ref.data[100], 60*sizeof(u32)) == 0);
+    assert(lut.data[99] == 0 && lut.data[160] == 0);
+  }
+
+  {
+    C3D_LightLutDA ref, lut;
+
+    LightLutDA_Quadratic(&ref, 1.0f, 30.0f, 0.2f, 0.01f);
+    LightLutDA_FromShape(&lut, C3D_LUT_QUADRATIC, 1.0f, 30.0f, 0.2f, 0.01f);
+    assert(std::memcmp(&lut, &ref, sizeof(lut)) == 0);
+  }
+
+  {
+    C3D_FogLut ref, lut;
+
+    FogLut_Exp(&ref, 0.03f, 1.2f, 0.1f, 200.0f);
+    FogLut_FromShape(&lut, C3D_LUT_EXP, 0.03f, 1.2f, 0.1f, 200.0f);
+    assert(std::memcmp(&lut, &ref, sizeof(lut)) == 0);
+  }
+}
+
+static void
+check_packetqueue()
+{
+  static constexpr unsigned count = 200000;
+  alignas(4) static u8 buf[1024];
+  C3D_PacketQueue q;
+
+  assert(!C3D_PacketQueueInit(&q, buf, 1000));
+  assert(C3D_PacketQueueInit(&q, buf, sizeof(buf)));
+  assert(C3D_PacketQueueEmpty(&q));
+  assert(!C3D_PacketBegin(&q, 0, sizeof(buf)/4));
+
+  // producer and consumer on separate threads, packet sizes chosen to hit every wrap offset
+  std::thread producer([&q]()
+  {
+    for (unsigned i = 0; i < count; ++i)
+    {
+      u32 size = 1 + i % 61;
+      u8 *p;
+      while (!(p = static_cast<u8*>(C3D_PacketBegin(&q, i & 0x7FFF, size))))
+        std::this_thread::yield();
+      for (u32 j = 0; j < size; ++j)
+        p[j] = static_cast<u8>(i + j);
+      C3D_PacketCommit(&q);
+    }
+  });
+
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const u8 *p;
+    u16 op;
+    u32 size;
+    while (!(p = static_cast<const u8*>(C3D_PacketPeek(&q, &op, &size))))
+      std::this_thread::yield();
+    assert(op == (i & 0x7FFF));
+    assert(size == 1 + i % 61);
+    for (u32 j = 0; j < size; ++j)
+      assert(p[j] == static_cast<u8>(i + j));
+    C3D_PacketPop(&q);
+  }
+
+  producer.join();
+  assert(C3D_PacketQueueEmpty(&q));
+  assert(!C3D_PacketPeek(&q, nullptr, nullptr));
+}
+
 int main(int argc, char *argv[])
 {
   std::random_device rd;
@@ -974,6 +1195,10 @@ int main(int argc, char *argv[])
 
   check_matrix(gen, dist);
   check_quaternion(gen, dist);
+  check_lutgen();
+  check_lutgen_builtins();
+  check_lutshape();
+  check_packetqueue();
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,106 @@
+/*
+ * lutgen - emits citro3d light/fog LUTs as C source
+ *
+ * The tables are built by the library's own LightLut/FogLut code, but with
+ * the host's libm rather than newlib. An entry may be off by one quantization
+ * step from the console where the two round powf/expf/cosf differently.
+ *
+ * usage: lutgen <spec>...
+ *   phong <name> <shininess>
+ *   spot  <name> <angle>
+ *   da    <name> <from> <to> <linear> <quad>
+ *   fog   <name> <density> <gradient> <near> <far>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <c3d/lightlut.h>
+#include <c3d/foglut.h>
+
+static void emitWords(const u32* data, int count)
+{
+	int i;
+	for (i = 0; i < count; i ++)
+		printf("%s0x%08X,", (i & 7) ? " " : "\n\t\t", (unsigned)data[i]);
+	printf("\n\t");
+}
+
+static void emitLightLut(const char* name, const C3D_LightLut* lut)
+{
+	printf("const C3D_LightLut %s =\n{\n\t{", name);
+	emitWords(lut->data, 256);
+	printf("},\n};\n\n");
+}
+
+static void emitLightLutDA(const char* name, const C3D_LightLutDA* lut)
+{
+	printf("const C3D_LightLutDA %s =\n{\n\t{{", name);
+	emitWords(lut->lut.data, 256);
+	printf("}},\n\t%af, %af,\n};\n\n", lut->bias, lut->scale);
+}
+
+static void emitFogLut(const char* name, const C3D_FogLut* lut)
+{
+	printf("const C3D_FogLut %s =\n{\n\t{", name);
+	emitWords(lut->data, 128);
+	printf("},\n};\n\n");
+}
+
+static int usage(void)
+{
+	fprintf(stderr,
+		"usage: lutgen <spec>...\n"
+		"  phong <name> <shininess>\n"
+		"  spot  <name> <angle>\n"
+		"  da    <name> <from> <to> <linear> <quad>\n"
+		"  fog   <name> <density> <gradient> <near> <far>\n");
+	return EXIT_FAILURE;
+}
+
+static float arg(char** argv, int i)
+{
+	return strtof(argv[i], NULL);
+}
+
+int main(int argc, char* argv[])
+{
+	int i = 1;
+	if (argc < 2)
+		return usage();
+
+	printf("// Generated by lutgen, do not edit\n");
+	printf("#include <c3d/lightlut.h>\n#include <c3d/foglut.h>\n\n");
+
+	while (i < argc)
+	{
+		const char* kind = argv[i];
+		if (strcmp(kind, "phong") == 0 && i+2 <= argc-1)
+		{
+			C3D_LightLut lut;
+			LightLut_Phong(&lut, arg(argv, i+2));
+			emitLightLut(argv[i+1], &lut);
+			i += 3;
+		} else if (strcmp(kind, "spot") == 0 && i+2 <= argc-1)
+		{
+			C3D_LightLut lut;
+			LightLut_Spotlight(&lut, arg(argv, i+2));
+			emitLightLut(argv[i+1], &lut);
+			i += 3;
+		} else if (strcmp(kind, "da") == 0 && i+5 <= argc-1)
+		{
+			C3D_LightLutDA lut;
+			LightLutDA_Quadratic(&lut, arg(argv, i+2), arg(argv, i+3), arg(argv, i+4), arg(argv, i+5));
+			emitLightLutDA(argv[i+1], &lut);
+			i += 6;
+		} else if (strcmp(kind, "fog") == 0 && i+5 <= argc-1)
+		{
+			C3D_FogLut lut;
+			FogLut_Exp(&lut, arg(argv, i+2), arg(argv, i+3), arg(argv, i+4), arg(argv, i+5));
+			emitFogLut(argv[i+1], &lut);
+			i += 6;
+		} else
+			return usage();
+	}
+
+	return EXIT_SUCCESS;
+}